@@ -0,0 +1,382 @@
+//
+//  Benchmark.cpp
+//  exercise
+//
+
+#include "Benchmark.h"
+#include "EntityStore.h"
+#include "CollisionKernels.h"
+#include "JobSystem.h"
+#include "ParticleSystem.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+
+constexpr float ARENA_HALF_WIDTH  = 5.0f,
+                ARENA_HALF_HEIGHT = 3.5f;
+
+constexpr float PI = 3.14159265358979f;     // MSVC has no M_PI without _USE_MATH_DEFINES
+
+constexpr float BENCH_TIMESTEP = 1.0f / 240.0f;
+constexpr int   BENCH_STEPS    = 20;
+
+// ————— SCENARIOS ————— //
+struct Scenario {
+    std::vector<int> balls;
+    std::vector<int> boxes;
+};
+
+// Balls and small static boxes scattered over the arena, identical for the same seed
+Scenario build_scenario(EntityStore& store, int ball_count, int box_count, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> x(-ARENA_HALF_WIDTH, ARENA_HALF_WIDTH);
+    std::uniform_real_distribution<float> y(-ARENA_HALF_HEIGHT, ARENA_HALF_HEIGHT);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+    Scenario scenario;
+    store.clear();
+
+    for (int i = 0; i < box_count; i++) {
+        int box = store.spawn();
+        store.positions[box] = glm::vec3(x(rng), y(rng), 0.0f);
+        store.scales[box]    = glm::vec3(0.25f, 0.5f, 0.0f);
+        store.shapes[box]    = i % 2 == 0 ? LEFT_PADDLE : RIGHT_PADDLE;
+        scenario.boxes.push_back(box);
+    }
+
+    for (int i = 0; i < ball_count; i++) {
+        int ball = store.spawn();
+        store.positions[ball] = glm::vec3(x(rng), y(rng), 0.0f);
+        store.movements[ball] = glm::vec3(direction(rng), direction(rng), 0.0f);
+        store.scales[ball]    = glm::vec3(0.1f, 0.1f, 0.0f);
+        store.speeds[ball]    = glm::vec3(3.0f, 0.5f, 0.0f);
+        store.shapes[ball]    = BALL;
+        scenario.balls.push_back(ball);
+    }
+
+    return scenario;
+}
+
+template <typename Step>
+double milliseconds_per_step(Step step)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_STEPS; i++) step();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / BENCH_STEPS;
+}
+
+// ————— BENCHMARKS ————— //
+int bench_broadphase()
+{
+    static const int BALL_COUNTS[] = { 1000, 5000, 10000, 20000, 50000 };
+    static const int BOX_COUNTS[]  = { 6, 100, 1000 };
+
+    EntityStore store;
+    int mismatches = 0;
+
+    printf("broadphase: balls vs boxes, %d steps each\n", BENCH_STEPS);
+    printf("%8s %8s %14s %14s %9s %7s\n", "balls", "boxes", "brute ms/step", "hash ms/step", "speedup", "same");
+
+    for (int box_count : BOX_COUNTS) {
+        for (int ball_count : BALL_COUNTS) {
+            Scenario scenario = build_scenario(store, ball_count, box_count, 1);
+            double brute = milliseconds_per_step([&] {
+                store.update_brute_force(scenario.balls, BENCH_TIMESTEP, scenario.boxes);
+            });
+            std::vector<glm::vec3> brute_positions = store.positions;
+
+            scenario = build_scenario(store, ball_count, box_count, 1);
+            double hash = milliseconds_per_step([&] {
+                store.update_broadphase(scenario.balls, BENCH_TIMESTEP, scenario.boxes);
+            });
+
+            bool same = brute_positions == store.positions;
+            mismatches += !same;
+            printf("%8d %8d %14.3f %14.3f %8.1fx %7s\n", ball_count, box_count, brute, hash, brute / hash,
+                   same ? "yes" : "NO");
+        }
+    }
+    return mismatches;
+}
+
+// Kernels against the scalar test on random pairs, checking every bit agrees
+int bench_narrowphase()
+{
+    static const int COUNTS[] = { 64, 1024, 16384, 262144 };
+    constexpr int REPEATS = 20;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coordinate(-2.0f, 2.0f);
+    std::uniform_real_distribution<float> extent(0.05f, 1.0f);
+    int total_mismatches = 0;
+
+    printf("narrowphase: %s kernel vs scalar circle_overlaps_box, %d repeats\n", collision_kernel_name(), REPEATS);
+    printf("%8s %16s %16s %16s %16s %10s\n", "pairs", "scalar 1-vs-N us", "kernel 1-vs-N us",
+           "scalar N-vs-1 us", "kernel N-vs-1 us", "mismatches");
+
+    for (int count : COUNTS) {
+        std::vector<float> x(count), y(count), half_widths(count), half_heights(count), radii(count);
+        for (int i = 0; i < count; i++) {
+            x[i] = coordinate(rng);
+            y[i] = coordinate(rng);
+            half_widths[i] = extent(rng);
+            half_heights[i] = extent(rng);
+            radii[i] = extent(rng);
+        }
+
+        std::vector<uint64_t> expected(hit_words(count)), hits(hit_words(count));
+        int mismatches = 0;
+        auto time = [&](auto work) {
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < REPEATS; r++) work();
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / REPEATS;
+        };
+
+        // one circle (at the origin) against every box
+        double scalar_one = time([&] {
+            std::fill(expected.begin(), expected.end(), 0);
+            for (int i = 0; i < count; i++) {
+                if (circle_overlaps_box(fabsf(0.0f - x[i]), fabsf(0.0f - y[i]), 0.5f, half_widths[i], half_heights[i]))
+                    expected[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        });
+        double kernel_one = time([&] {
+            circle_vs_boxes(0.0f, 0.0f, 0.5f, x.data(), y.data(), half_widths.data(), half_heights.data(), count, hits.data());
+        });
+        for (int i = 0; i < count; i++) mismatches += test_hit(expected.data(), i) != test_hit(hits.data(), i);
+
+        // every circle against one box at the origin
+        double scalar_many = time([&] {
+            std::fill(expected.begin(), expected.end(), 0);
+            for (int i = 0; i < count; i++) {
+                if (circle_overlaps_box(fabsf(x[i] - 0.0f), fabsf(y[i] - 0.0f), radii[i], 0.5f, 0.25f))
+                    expected[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        });
+        double kernel_many = time([&] {
+            circles_vs_box(x.data(), y.data(), radii.data(), count, 0.0f, 0.0f, 0.5f, 0.25f, hits.data());
+        });
+        for (int i = 0; i < count; i++) mismatches += test_hit(expected.data(), i) != test_hit(hits.data(), i);
+
+        printf("%8d %16.2f %16.2f %16.2f %16.2f %10d\n", count, scalar_one, kernel_one, scalar_many, kernel_many, mismatches);
+        total_mismatches += mismatches;
+    }
+    return total_mismatches;
+}
+
+// Fires balls at a paddle-sized box with ever longer steps and counts how many get past
+void bench_tunnelling()
+{
+    static const float STEP_LENGTHS[] = { 0.05f, 0.25f, 0.5f, 1.0f, 2.0f, 4.0f };    // ball travel per step
+    constexpr int SHOTS = 1000;
+
+    EntityStore store;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> aim(-0.85f, 0.85f);     // every shot clips the paddle (0.5 + 0.375)
+
+    printf("tunnelling: %d balls (0.75 wide) fired at a 0.25 x 1 paddle\n", SHOTS);
+    printf("%12s %16s %16s\n", "travel/step", "missed discrete", "missed swept");
+
+    for (float travel : STEP_LENGTHS) {
+        int missed[2] = { 0, 0 };
+
+        for (int swept = 0; swept < 2; swept++) {
+            store.continuous_collisions = swept;
+
+            for (int shot = 0; shot < SHOTS; shot++) {
+                store.clear();
+                int paddle = store.spawn();
+                store.positions[paddle] = glm::vec3(0.0f);
+                store.scales[paddle]    = glm::vec3(0.25f, 1.0f, 0.0f);
+                store.shapes[paddle]    = RIGHT_PADDLE;
+
+                int ball = store.spawn();
+                store.positions[ball] = glm::vec3(-3.0f - aim(rng), aim(rng), 0.0f);
+                store.scales[ball]    = glm::vec3(0.75f, 0.75f, 0.0f);
+                store.shapes[ball]    = BALL;
+                store.movements[ball] = glm::vec3(1.0f, 0.0f, 0.0f);
+                store.speeds[ball]    = glm::vec3(travel / BENCH_TIMESTEP, 0.0f, 0.0f);
+
+                std::vector<int> balls = { ball }, boxes = { paddle };
+                for (int step = 0; step < (int) (8.0f / travel) + 1; step++) {
+                    store.update(balls, BENCH_TIMESTEP, boxes);
+                }
+
+                if (store.positions[ball].x > 0.0f) missed[swept]++;    // ended up behind the paddle
+            }
+        }
+
+        printf("%12.2f %16d %16d\n", travel, missed[0], missed[1]);
+    }
+}
+
+// Ball-to-ball contacts with the balls sized to cover about a fifth of the arena
+void bench_balls()
+{
+    static const int BALL_COUNTS[] = { 1000, 5000, 10000, 20000 };
+    constexpr float COVERAGE = 0.2f;
+    constexpr double BUDGET_MS = 4.0;       // what a 240 Hz step can afford
+
+    EntityStore store;
+
+    printf("balls: ball-to-ball collisions at %.0f%% coverage, %d steps each\n", COVERAGE * 100.0f, BENCH_STEPS);
+    printf("%8s %10s %12s %16s %16s %8s\n", "balls", "diameter", "ms/step", "pairs tested/s", "contacts/step", "budget");
+
+    for (int ball_count : BALL_COUNTS) {
+        float diameter = 2.0f * sqrtf(COVERAGE * 4.0f * ARENA_HALF_WIDTH * ARENA_HALF_HEIGHT / (ball_count * PI));
+
+        Scenario scenario = build_scenario(store, ball_count, 0, 1);
+        for (int ball : scenario.balls) {
+            store.scales[ball] = glm::vec3(diameter, diameter, 0.0f);
+            store.masses[ball] = diameter * diameter;
+        }
+
+        store.ball_pairs_tested = store.ball_contacts = 0;
+        double ms = milliseconds_per_step([&] {
+            store.update(scenario.balls, BENCH_TIMESTEP, scenario.boxes);
+            store.collide_balls(scenario.balls);
+        });
+
+        printf("%8d %10.4f %12.3f %16.3g %16.1f %8s\n", ball_count, diameter, ms,
+               store.ball_pairs_tested / (ms * BENCH_STEPS / 1000.0), (double) store.ball_contacts / BENCH_STEPS,
+               ms <= BUDGET_MS ? "ok" : "OVER");
+    }
+}
+
+// The same busy scene on different numbers of workers; every run must match the single-threaded one
+int bench_jobs()
+{
+    static const int WORKER_COUNTS[] = { 0, 1, 3, 7 };
+    static const int BOX_COUNTS[] = { 6, 100 };     // brute force and broadphase paths
+    constexpr int BALL_COUNT = 20000;
+    constexpr float DIAMETER = 0.03f;
+
+    EntityStore store;
+    int default_workers = JobSystem::default_worker_count();
+    int mismatches = 0;
+
+    printf("jobs: %d balls with ball-to-ball collisions, %d steps each, %d cores\n", BALL_COUNT, BENCH_STEPS,
+           (int) std::thread::hardware_concurrency());
+    printf("%8s %8s %12s %9s %7s\n", "boxes", "workers", "ms/step", "speedup", "same");
+
+    for (int box_count : BOX_COUNTS) {
+        std::vector<glm::vec3> expected_positions, expected_movements;
+        double single = 0.0;
+
+        for (int workers : WORKER_COUNTS) {
+            g_jobs.set_worker_count(workers);
+
+            Scenario scenario = build_scenario(store, BALL_COUNT, box_count, 1);
+            for (int ball : scenario.balls) store.scales[ball] = glm::vec3(DIAMETER, DIAMETER, 0.0f);
+
+            double ms = milliseconds_per_step([&] {
+                store.update(scenario.balls, BENCH_TIMESTEP, scenario.boxes);
+                store.collide_balls(scenario.balls);
+            });
+
+            if (workers == 0) {
+                expected_positions = store.positions;
+                expected_movements = store.movements;
+                single = ms;
+            }
+
+            bool same = store.positions == expected_positions && store.movements == expected_movements;
+            mismatches += !same;
+            printf("%8d %8d %12.3f %8.1fx %7s\n", box_count, workers, ms, single / ms, same ? "yes" : "NO");
+        }
+    }
+
+    g_jobs.set_worker_count(default_workers);
+    return mismatches;
+}
+
+// A mostly static scene: how much of a frame goes on entities that aren't changing
+void bench_transforms()
+{
+    static const float MOVING_FRACTIONS[] = { 0.0f, 0.01f, 0.1f, 0.5f, 1.0f };
+    constexpr int ENTITY_COUNT = 10000;
+    constexpr int FRAMES = 100;
+
+    EntityStore store;
+
+    printf("transforms: %d entities, %d frames of integrate + interpolate each\n", ENTITY_COUNT, FRAMES);
+    printf("%8s %16s %16s %9s %16s\n", "moving", "every ms/frame", "changed ms/frame", "speedup", "rebuilt/frame");
+
+    for (float moving : MOVING_FRACTIONS) {
+        double ms[2];
+        long long rebuilt = 0;
+
+        for (int skip = 0; skip < 2; skip++) {
+            Scenario scenario = build_scenario(store, (int) (ENTITY_COUNT * moving), ENTITY_COUNT - (int) (ENTITY_COUNT * moving), 1);
+            store.skip_unchanged = skip;
+            store.transforms_built = 0;
+
+            auto start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < FRAMES; frame++) {
+                store.save_previous();
+                for (int id = 0; id < store.size(); id++) store.integrate(id, BENCH_TIMESTEP);
+                store.interpolate(0.5f);
+            }
+            ms[skip] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / FRAMES;
+            rebuilt = store.transforms_built / FRAMES;
+        }
+
+        printf("%7.0f%% %16.3f %16.3f %8.1fx %16lld\n", moving * 100.0f, ms[0], ms[1], ms[0] / ms[1], rebuilt);
+    }
+}
+
+// A frame of sparkles: integrate and cull, then pack for the renderer, with the pool
+// refilled to the same size every frame
+void bench_particles()
+{
+    static const int LIVE_COUNTS[] = { 1000, 10000, 50000, 100000 };
+    constexpr int BURST = 48;
+
+    ParticleSystem particles;
+    std::vector<ParticleSystem::Instance> instances;
+
+    printf("particles: %d frames at 60 Hz each\n", BENCH_STEPS);
+    printf("%8s %12s %12s\n", "live", "update ms", "pack ms");
+
+    for (int live : LIVE_COUNTS) {
+        particles.clear();
+        auto refill = [&] { while (particles.count() + BURST <= live) particles.burst(0.0f, 0.0f, BURST, 3.0f); };
+
+        double update_ms = 0.0, pack_ms = 0.0;
+        for (int frame = 0; frame < BENCH_STEPS; frame++) {
+            refill();
+
+            auto start = std::chrono::steady_clock::now();
+            particles.update(1.0f / 60.0f);
+            auto updated = std::chrono::steady_clock::now();
+            instances.clear();
+            particles.pack(instances);
+            auto packed = std::chrono::steady_clock::now();
+
+            update_ms += std::chrono::duration<double, std::milli>(updated - start).count();
+            pack_ms   += std::chrono::duration<double, std::milli>(packed - updated).count();
+        }
+
+        printf("%8d %12.3f %12.3f\n", live, update_ms / BENCH_STEPS, pack_ms / BENCH_STEPS);
+    }
+}
+
+int run_benchmarks(int argc, char* argv[])
+{
+    std::string name = argc > 0 ? argv[0] : "all";
+    int mismatches = 0;
+
+    if (name == "all" || name == "broadphase") mismatches += bench_broadphase();
+    if (name == "all" || name == "narrowphase") mismatches += bench_narrowphase();
+    if (name == "all" || name == "tunnelling") bench_tunnelling();
+    if (name == "all" || name == "balls") bench_balls();
+    if (name == "all" || name == "jobs") mismatches += bench_jobs();
+    if (name == "all" || name == "transforms") bench_transforms();
+    if (name == "all" || name == "particles") bench_particles();
+
+    if (mismatches > 0) fprintf(stderr, "Error: %d benchmark results differ from their reference.\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+//
+//  Benchmark.h
+//  exercise
+//
+//  Simulation microbenchmarks, run without a window:
+//      ./homework_2 --bench [name]     (or ./disco_pong_headless --bench [name])
+//  With no name every benchmark runs. The ones that check a fast path against
+//  a reference return how many results differed, and any difference makes the
+//  run exit with 1, so sweeps can catch regressions.
+//
+
+#pragma once
+
+int bench_broadphase();
+int bench_narrowphase();
+void bench_tunnelling();
+void bench_balls();
+int bench_jobs();
+void bench_transforms();
+void bench_particles();
+
+int run_benchmarks(int argc, char* argv[]);
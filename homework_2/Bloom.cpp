@@ -0,0 +1,267 @@
+//
+//  Bloom.cpp
+//  exercise
+//
+
+#ifndef HEADLESS
+#define GL_SILENCE_DEPRECATION
+
+#include "Bloom.h"
+#include "GpuTimer.h"
+#include "ShaderProgram.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+static const char* PASS_NAMES[] = { "bloom bright", "bloom blur x", "bloom blur y", "bloom composite" };
+
+// A texture to draw into, with its framebuffer, or 0 if the driver won't have it
+static GLuint make_target(int width, int height, GLuint* texture)
+{
+    glGenTextures(1, texture);
+    g_gl_state.bind_texture(*texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *texture, 0);
+
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE ? framebuffer : 0;
+}
+
+void Bloom::load(int width, int height, const BloomSettings& settings, ShaderProgram* bright_program,
+                 ShaderProgram* blur_programs, ShaderProgram* composite_program)
+{
+    m_settings = settings;
+    m_settings.downsample = settings.downsample > 2 ? 4 : 2;
+    m_settings.taps = std::min(std::max(settings.taps, 1), MAX_TAPS);
+    m_downsample = m_settings.downsample;
+    m_taps = m_settings.taps;
+    if (!m_settings.enabled) return;
+
+    m_width = width;
+    m_height = height;
+    m_bright_program = bright_program;
+    m_blur_programs = blur_programs;
+    m_composite_program = composite_program;
+
+    // a triangle past every edge of the screen covers it with no seam down the middle
+    static const float TRIANGLE[] = { -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f };
+    glGenBuffers(1, &m_triangle_buffer);
+    g_gl_state.bind_array_buffer(m_triangle_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(TRIANGLE), TRIANGLE, GL_STATIC_DRAW);
+
+    GLint target;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
+
+    m_scene_framebuffer = make_target(width, height, &m_scene_texture);
+    bool complete = m_scene_framebuffer != 0;
+    for (int i = 0; i < 2; i++) {
+        m_blur_framebuffers[i] = make_target(width / m_downsample, height / m_downsample, &m_blur_textures[i]);
+        complete = complete && m_blur_framebuffers[i] != 0;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+    if (!complete) {
+        std::cerr << "Error: bloom framebuffers are incomplete, drawing without bloom\n";
+        m_settings.enabled = false;
+        return;
+    }
+
+    m_bright_program->use();
+    glUniform1f(glGetUniformLocation(m_bright_program->get_program_id(), "threshold"), m_settings.threshold);
+
+    m_composite_program->use();
+    GLuint composite_id = m_composite_program->get_program_id();
+    glUniform1i(glGetUniformLocation(composite_id, "scene"), 0);
+    glUniform1i(glGetUniformLocation(composite_id, "bloom"), 1);
+    glUniform1f(glGetUniformLocation(composite_id, "intensity"), m_settings.intensity);
+
+    for (int pass = 0; pass < PASS_COUNT; pass++) m_zones[pass] = g_gpu_timer.add_zone(PASS_NAMES[pass]);
+
+    // without timestamps the passes can't be timed inside the zone around the whole frame
+    if (m_settings.budget > 0.0f && !g_gpu_timer.nests()) {
+        std::cerr << "Bloom: no GPU timestamps on this driver, so the " << m_settings.budget
+                  << " ms budget is ignored\n";
+    }
+}
+
+// Sizes both blur textures for m_downsample; the framebuffers stay attached to them
+void Bloom::allocate_blur_targets()
+{
+    for (GLuint texture : m_blur_textures) {
+        g_gl_state.bind_texture(texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width / m_downsample, m_height / m_downsample, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    reset_timings();
+}
+
+// After anything that changes what the passes cost, so the next budget check sees only the new setting
+void Bloom::reset_timings()
+{
+    for (int zone : m_zones) {
+        if (zone >= 0) g_gpu_timer.reset(zone);
+    }
+}
+
+// The one for m_taps, given its weights the first time after a change: a Gaussian over
+// 2 * m_taps texels each side, folded so each tap reads two texels through bilinear filtering
+ShaderProgram* Bloom::use_blur_program()
+{
+    ShaderProgram* program = &m_blur_programs[m_taps - 1];
+    program->use();
+    if (m_uploaded_taps == m_taps) return program;
+
+    int radius = 2 * m_taps;
+    float sigma = (float) m_taps;
+    std::vector<float> texel_weights(radius + 1);
+    for (int i = 0; i <= radius; i++) texel_weights[i] = expf(-(float) (i * i) / (2.0f * sigma * sigma));
+
+    float weights[MAX_TAPS + 1] = {}, offsets[MAX_TAPS + 1] = {};
+    weights[0] = texel_weights[0];
+    float total = weights[0];
+
+    for (int tap = 1; tap <= m_taps; tap++) {
+        float inner = texel_weights[2 * tap - 1], outer = texel_weights[2 * tap];
+        weights[tap] = inner + outer;
+        offsets[tap] = ((2 * tap - 1) * inner + 2 * tap * outer) / weights[tap];
+        total += 2.0f * weights[tap];
+    }
+    for (float& weight : weights) weight /= total;
+
+    GLuint program_id = program->get_program_id();
+    glUniform1fv(glGetUniformLocation(program_id, "weights"), m_taps + 1, weights);
+    glUniform1fv(glGetUniformLocation(program_id, "offsets"), m_taps + 1, offsets);
+    m_direction_uniform = glGetUniformLocation(program_id, "direction");
+    m_uploaded_taps = m_taps;
+    return program;
+}
+
+void Bloom::draw_triangle(ShaderProgram* program)
+{
+    GLuint position = program->get_position_attribute();
+
+    program->use();
+    g_gl_state.bind_array_buffer(m_triangle_buffer);
+    glVertexAttribPointer(position, 2, GL_FLOAT, false, 0, nullptr);
+    g_gl_state.use_attributes(GLState::bit(position));
+
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void Bloom::begin()
+{
+    if (!m_settings.enabled) return;
+
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_target_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_scene_framebuffer);
+}
+
+void Bloom::end()
+{
+    if (!m_settings.enabled) return;
+
+    int width = m_width / m_downsample, height = m_height / m_downsample;
+
+    glDisable(GL_BLEND);
+    glViewport(0, 0, width, height);
+
+    // frame -> small texture 0, keeping only what's bright
+    {
+        GpuTimer::Scope zone(g_gpu_timer, m_zones[PASS_BRIGHT]);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_blur_framebuffers[0]);
+        g_gl_state.bind_texture(m_scene_texture);
+        draw_triangle(m_bright_program);
+    }
+
+    ShaderProgram* blur_program = use_blur_program();
+
+    // 0 -> 1 across, then 1 -> 0 down
+    {
+        GpuTimer::Scope zone(g_gpu_timer, m_zones[PASS_BLUR_X]);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_blur_framebuffers[1]);
+        g_gl_state.bind_texture(m_blur_textures[0]);
+        glUniform2f(m_direction_uniform, 1.0f / width, 0.0f);
+        draw_triangle(blur_program);
+    }
+    {
+        GpuTimer::Scope zone(g_gpu_timer, m_zones[PASS_BLUR_Y]);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_blur_framebuffers[0]);
+        g_gl_state.bind_texture(m_blur_textures[1]);
+        glUniform2f(m_direction_uniform, 0.0f, 1.0f / height);
+        draw_triangle(blur_program);
+    }
+
+    // frame + glow -> wherever the frame was going. g_gl_state only tracks unit 0, so the
+    // glow's unit is set directly and left active on 0
+    {
+        GpuTimer::Scope zone(g_gpu_timer, m_zones[PASS_COMPOSITE]);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_target_framebuffer);
+        glViewport(0, 0, m_width, m_height);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, m_blur_textures[0]);
+        glActiveTexture(GL_TEXTURE0);
+        g_gl_state.bind_texture(m_scene_texture);
+        draw_triangle(m_composite_program);
+    }
+
+    glEnable(GL_BLEND);
+    fit_budget();
+}
+
+// Over budget, one tap fewer, or quarter size once down to one tap; back up the same way
+// when the next step up should still leave a fifth of the budget spare
+void Bloom::fit_budget()
+{
+    if (m_settings.budget <= 0.0f || !g_gpu_timer.measured(m_zones[PASS_COMPOSITE]) ||
+        ++m_frames_since_fit < FIT_INTERVAL) return;
+    m_frames_since_fit = 0;
+
+    double cost = milliseconds();
+
+    if (cost > m_settings.budget) {
+        if (m_taps > 1) {
+            m_taps--;
+            reset_timings();
+        }
+        else if (m_downsample < 4) {
+            m_downsample = 4;
+            allocate_blur_targets();
+        }
+        return;
+    }
+
+    // a quarter of the size has a quarter of the pixels; an extra tap adds two texture reads to each blur
+    bool finer = m_downsample > m_settings.downsample;
+    double growth = finer ? 4.0 : (2.0 * m_taps + 3.0) / (2.0 * m_taps + 1.0);
+    if (cost * growth > m_settings.budget * 0.8) return;
+
+    if (finer) {
+        m_downsample = m_settings.downsample;
+        allocate_blur_targets();
+    }
+    else if (m_taps < m_settings.taps) {
+        m_taps++;
+        reset_timings();
+    }
+}
+
+double Bloom::milliseconds(Pass pass) const
+{
+    return m_zones[pass] >= 0 ? g_gpu_timer.milliseconds(m_zones[pass]) : 0.0;
+}
+
+double Bloom::milliseconds() const
+{
+    double total = 0.0;
+    for (int pass = 0; pass < PASS_COUNT; pass++) total += milliseconds((Pass) pass);
+    return total;
+}
+#endif
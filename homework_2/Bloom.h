@@ -0,0 +1,85 @@
+//
+//  Bloom.h
+//  exercise
+//
+//  Makes the bright parts of the frame glow. Between begin() and end() the
+//  frame is drawn into a texture instead of the screen; end() then keeps only
+//  what's brighter than a threshold, shrinking it to half or quarter size on
+//  the way, blurs that horizontally then vertically, and adds it back on top
+//  of the frame in whatever framebuffer was bound at begin(). The small size
+//  and the separable blur keep it cheap enough for software GL, and with a
+//  budget set it trades taps, then resolution, to stay inside it. Each pass
+//  is timed on the GPU through g_gpu_timer.
+//
+
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+
+class ShaderProgram;
+
+struct BloomSettings {
+    bool enabled = true;
+    int downsample = 2;         // 2 blurs at half the frame's size, 4 at a quarter
+    int taps = 3;               // bilinear taps either side of the centre in each blur, 1 to MAX_TAPS
+    float threshold = 0.6f;     // brightest channel that stays dark
+    float intensity = 0.8f;
+    float budget = 2.0f;        // milliseconds of GPU time for all four passes; 0 to never adapt
+};
+
+class Bloom
+{
+public:
+    enum Pass { PASS_BRIGHT, PASS_BLUR_X, PASS_BLUR_Y, PASS_COMPOSITE, PASS_COUNT };
+    static constexpr int MAX_TAPS = 7;
+
+private:
+    static constexpr int FIT_INTERVAL = 30;     // frames between budget checks, so the timings can settle
+
+    BloomSettings m_settings;               // as asked for; the budget only ever goes down from here
+    int m_downsample = 2, m_taps = 3;       // what's actually drawn
+    int m_uploaded_taps = 0;                // the blur program last given its weights
+    int m_frames_since_fit = 0;
+
+    ShaderProgram* m_bright_program = nullptr;
+    ShaderProgram* m_blur_programs = nullptr;  // one per tap count, from 1
+    ShaderProgram* m_composite_program = nullptr;
+    GLuint m_triangle_buffer = 0;
+
+    int m_width = 0, m_height = 0;
+    GLuint m_scene_framebuffer = 0, m_scene_texture = 0;
+    GLuint m_blur_framebuffers[2] = {}, m_blur_textures[2] = {};   // ping-ponged between the passes
+    GLint m_target_framebuffer = 0;         // the one bound at begin()
+
+    int m_zones[PASS_COUNT] = { -1, -1, -1, -1 };   // in g_gpu_timer, once loaded
+    GLint m_direction_uniform = -1;         // in the current blur program
+
+    void allocate_blur_targets();
+    void reset_timings();
+    ShaderProgram* use_blur_program();
+    void draw_triangle(ShaderProgram* program);
+    void fit_budget();
+
+public:
+    // Once there's a GL context and g_gpu_timer is loaded. blur_programs are
+    // shaders/fragment_blur.glsl with TAPS defined as 1, 2, ... up to settings.taps,
+    // since the budget may need any of them. Turns itself off, saying so, if the
+    // framebuffers can't be made.
+    void load(int width, int height, const BloomSettings& settings, ShaderProgram* bright_program,
+              ShaderProgram* blur_programs, ShaderProgram* composite_program);
+
+    // Around everything that draws the frame
+    void begin();
+    void end();
+
+    bool enabled() const { return m_settings.enabled; }
+    int downsample() const { return m_downsample; }
+    int taps() const { return m_taps; }
+
+    double milliseconds(Pass pass) const;   // GPU time, averaged over recent frames
+    double milliseconds() const;            // all passes together
+};
@@ -0,0 +1,277 @@
+//
+//  CollisionKernels.cpp
+//  exercise
+//
+
+#include "CollisionKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// only x86-64 always has SSE2; 32-bit builds get the kernels when they target it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define COLLISION_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+// ————— SCALAR ————— //
+static void circle_vs_boxes_scalar(float x, float y, float radius,
+                                   const float* box_x, const float* box_y, const float* half_widths, const float* half_heights,
+                                   int first, int count, uint64_t* hits)
+{
+    for (int i = first; i < count; i++) {
+        if (circle_overlaps_box(fabsf(x - box_x[i]), fabsf(y - box_y[i]), radius, half_widths[i], half_heights[i]))
+            hits[i / 64] |= uint64_t(1) << (i % 64);
+    }
+}
+
+static void circles_vs_box_scalar(const float* x, const float* y, const float* radii, int first, int count,
+                                  float box_x, float box_y, float half_width, float half_height, uint64_t* hits)
+{
+    for (int i = first; i < count; i++) {
+        if (circle_overlaps_box(fabsf(x[i] - box_x), fabsf(y[i] - box_y), radii[i], half_width, half_height))
+            hits[i / 64] |= uint64_t(1) << (i % 64);
+    }
+}
+
+// ————— SWEEPS ————— //
+// Entry time of the segment start + t * move, t in [0, 1], into a box centred on the
+// origin; -1 for a miss or when the segment starts inside
+static float segment_box_entry(float x, float y, float move_x, float move_y, float half_width, float half_height)
+{
+    float t_enter = -INFINITY, t_exit = INFINITY;
+    float start[2] = { x, y }, move[2] = { move_x, move_y }, half[2] = { half_width, half_height };
+
+    for (int axis = 0; axis < 2; axis++) {
+        if (move[axis] == 0.0f) {
+            if (fabsf(start[axis]) > half[axis]) return -1.0f;     // parallel and outside this slab
+            continue;
+        }
+
+        float t1 = (-half[axis] - start[axis]) / move[axis];
+        float t2 = ( half[axis] - start[axis]) / move[axis];
+        if (t1 > t2) std::swap(t1, t2);
+
+        t_enter = std::max(t_enter, t1);
+        t_exit  = std::min(t_exit, t2);
+    }
+
+    if (t_enter > t_exit || t_enter <= 0.0f || t_enter > 1.0f) return -1.0f;
+    return t_enter;
+}
+
+// Entry time into a circle centred on the origin, same conventions
+static float segment_circle_entry(float x, float y, float move_x, float move_y, float radius)
+{
+    float a = move_x * move_x + move_y * move_y;
+    float b = x * move_x + y * move_y;
+    float c = x * x + y * y - radius * radius;
+
+    if (a == 0.0f || c <= 0.0f || b >= 0.0f) return -1.0f;         // not moving, inside, or moving away
+
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) return -1.0f;
+
+    float t = (-b - sqrtf(discriminant)) / a;
+    return t <= 1.0f ? t : -1.0f;
+}
+
+// The circle's centre against the box grown by the radius: two overlapping slabs for the
+// faces plus a circle on each corner. The earliest of the six entries is the contact.
+float sweep_circle_box(float x, float y, float move_x, float move_y, float radius,
+                       float box_x, float box_y, float half_width, float half_height)
+{
+    float start_x = x - box_x, start_y = y - box_y;
+
+    if (circle_overlaps_box(fabsf(start_x), fabsf(start_y), radius, half_width, half_height)) return -1.0f;
+
+    float earliest = INFINITY;
+    float t = segment_box_entry(start_x, start_y, move_x, move_y, half_width + radius, half_height);
+    if (t >= 0.0f) earliest = std::min(earliest, t);
+
+    t = segment_box_entry(start_x, start_y, move_x, move_y, half_width, half_height + radius);
+    if (t >= 0.0f) earliest = std::min(earliest, t);
+
+    for (int corner = 0; corner < 4; corner++) {
+        float corner_x = corner & 1 ? half_width : -half_width;
+        float corner_y = corner & 2 ? half_height : -half_height;
+
+        t = segment_circle_entry(start_x - corner_x, start_y - corner_y, move_x, move_y, radius);
+        if (t >= 0.0f) earliest = std::min(earliest, t);
+    }
+
+    return earliest == INFINITY ? -1.0f : earliest;
+}
+
+#ifdef COLLISION_X86
+// ————— SSE2 ————— //
+static inline __m128 overlap_mask_sse2(__m128 dx, __m128 dy, __m128 r, __m128 hw, __m128 hh)
+{
+    __m128 in_x    = _mm_cmple_ps(dx, _mm_add_ps(hw, r));
+    __m128 in_y    = _mm_cmple_ps(dy, _mm_add_ps(hh, r));
+    __m128 edge    = _mm_or_ps(_mm_cmple_ps(dx, hw), _mm_cmple_ps(dy, hh));
+    __m128 cx      = _mm_sub_ps(dx, hw);
+    __m128 cy      = _mm_sub_ps(dy, hh);
+    __m128 corner  = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(r, r));
+    return _mm_and_ps(_mm_and_ps(in_x, in_y), _mm_or_ps(edge, corner));
+}
+
+static inline __m128 abs_sse2(__m128 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+
+static void circle_vs_boxes_sse2(float x, float y, float radius,
+                                 const float* box_x, const float* box_y, const float* half_widths, const float* half_heights,
+                                 int count, uint64_t* hits)
+{
+    __m128 cx = _mm_set1_ps(x), cy = _mm_set1_ps(y), r = _mm_set1_ps(radius);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = abs_sse2(_mm_sub_ps(cx, _mm_loadu_ps(box_x + i)));
+        __m128 dy = abs_sse2(_mm_sub_ps(cy, _mm_loadu_ps(box_y + i)));
+        uint64_t bits = (uint64_t) _mm_movemask_ps(overlap_mask_sse2(dx, dy, r, _mm_loadu_ps(half_widths + i),
+                                                                     _mm_loadu_ps(half_heights + i)));
+        hits[i / 64] |= bits << (i % 64);
+    }
+    circle_vs_boxes_scalar(x, y, radius, box_x, box_y, half_widths, half_heights, i, count, hits);
+}
+
+static void circles_vs_box_sse2(const float* x, const float* y, const float* radii, int count,
+                                float box_x, float box_y, float half_width, float half_height, uint64_t* hits)
+{
+    __m128 bx = _mm_set1_ps(box_x), by = _mm_set1_ps(box_y);
+    __m128 hw = _mm_set1_ps(half_width), hh = _mm_set1_ps(half_height);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = abs_sse2(_mm_sub_ps(_mm_loadu_ps(x + i), bx));
+        __m128 dy = abs_sse2(_mm_sub_ps(_mm_loadu_ps(y + i), by));
+        uint64_t bits = (uint64_t) _mm_movemask_ps(overlap_mask_sse2(dx, dy, _mm_loadu_ps(radii + i), hw, hh));
+        hits[i / 64] |= bits << (i % 64);
+    }
+    circles_vs_box_scalar(x, y, radii, i, count, box_x, box_y, half_width, half_height, hits);
+}
+
+// ————— AVX2 ————— //
+// Compiled for AVX2 regardless of the project's flags; only called once the CPU says it has it.
+// No FMA on purpose: a fused multiply-add rounds differently from the scalar test.
+// MSVC emits AVX2 intrinsics whatever /arch says, so it needs no attribute.
+#ifdef _MSC_VER
+    #define AVX2_TARGET
+#else
+    #define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+AVX2_TARGET static inline __m256 overlap_mask_avx2(__m256 dx, __m256 dy, __m256 r, __m256 hw, __m256 hh)
+{
+    __m256 in_x    = _mm256_cmp_ps(dx, _mm256_add_ps(hw, r), _CMP_LE_OQ);
+    __m256 in_y    = _mm256_cmp_ps(dy, _mm256_add_ps(hh, r), _CMP_LE_OQ);
+    __m256 edge    = _mm256_or_ps(_mm256_cmp_ps(dx, hw, _CMP_LE_OQ), _mm256_cmp_ps(dy, hh, _CMP_LE_OQ));
+    __m256 cx      = _mm256_sub_ps(dx, hw);
+    __m256 cy      = _mm256_sub_ps(dy, hh);
+    __m256 corner  = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)),
+                                   _mm256_mul_ps(r, r), _CMP_LE_OQ);
+    return _mm256_and_ps(_mm256_and_ps(in_x, in_y), _mm256_or_ps(edge, corner));
+}
+
+AVX2_TARGET static inline __m256 abs_avx2(__m256 v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+
+AVX2_TARGET static void circle_vs_boxes_avx2(float x, float y, float radius,
+                                             const float* box_x, const float* box_y, const float* half_widths,
+                                             const float* half_heights, int count, uint64_t* hits)
+{
+    __m256 cx = _mm256_set1_ps(x), cy = _mm256_set1_ps(y), r = _mm256_set1_ps(radius);
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = abs_avx2(_mm256_sub_ps(cx, _mm256_loadu_ps(box_x + i)));
+        __m256 dy = abs_avx2(_mm256_sub_ps(cy, _mm256_loadu_ps(box_y + i)));
+        uint64_t bits = (uint64_t) _mm256_movemask_ps(overlap_mask_avx2(dx, dy, r, _mm256_loadu_ps(half_widths + i),
+                                                                        _mm256_loadu_ps(half_heights + i)));
+        hits[i / 64] |= bits << (i % 64);
+    }
+    circle_vs_boxes_scalar(x, y, radius, box_x, box_y, half_widths, half_heights, i, count, hits);
+}
+
+AVX2_TARGET static void circles_vs_box_avx2(const float* x, const float* y, const float* radii, int count,
+                                            float box_x, float box_y, float half_width, float half_height, uint64_t* hits)
+{
+    __m256 bx = _mm256_set1_ps(box_x), by = _mm256_set1_ps(box_y);
+    __m256 hw = _mm256_set1_ps(half_width), hh = _mm256_set1_ps(half_height);
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = abs_avx2(_mm256_sub_ps(_mm256_loadu_ps(x + i), bx));
+        __m256 dy = abs_avx2(_mm256_sub_ps(_mm256_loadu_ps(y + i), by));
+        uint64_t bits = (uint64_t) _mm256_movemask_ps(overlap_mask_avx2(dx, dy, _mm256_loadu_ps(radii + i), hw, hh));
+        hits[i / 64] |= bits << (i % 64);
+    }
+    circles_vs_box_scalar(x, y, radii, i, count, box_x, box_y, half_width, half_height, hits);
+}
+
+#ifdef _MSC_VER
+// The CPU has to have AVX2 and the OS has to save the YMM registers across context switches
+static bool cpu_has_avx2()
+{
+    int registers[4];
+    __cpuid(registers, 0);
+    if (registers[0] < 7) return false;
+
+    __cpuid(registers, 1);
+    bool osxsave = (registers[2] & (1 << 27)) != 0, avx = (registers[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(registers, 7, 0);
+    return (registers[1] & (1 << 5)) != 0;
+}
+#endif
+
+static bool has_avx2()
+{
+#ifdef _MSC_VER
+    static const bool supported = cpu_has_avx2();
+#else
+    static const bool supported = __builtin_cpu_supports("avx2");
+#endif
+    return supported;
+}
+#endif
+
+// ————— DISPATCH ————— //
+void circle_vs_boxes(float x, float y, float radius,
+                     const float* box_x, const float* box_y, const float* half_widths, const float* half_heights,
+                     int count, uint64_t* hits)
+{
+    memset(hits, 0, hit_words(count) * sizeof(uint64_t));
+
+#ifdef COLLISION_X86
+    if (has_avx2()) circle_vs_boxes_avx2(x, y, radius, box_x, box_y, half_widths, half_heights, count, hits);
+    else circle_vs_boxes_sse2(x, y, radius, box_x, box_y, half_widths, half_heights, count, hits);
+#else
+    circle_vs_boxes_scalar(x, y, radius, box_x, box_y, half_widths, half_heights, 0, count, hits);
+#endif
+}
+
+void circles_vs_box(const float* x, const float* y, const float* radii, int count,
+                    float box_x, float box_y, float half_width, float half_height, uint64_t* hits)
+{
+    memset(hits, 0, hit_words(count) * sizeof(uint64_t));
+
+#ifdef COLLISION_X86
+    if (has_avx2()) circles_vs_box_avx2(x, y, radii, count, box_x, box_y, half_width, half_height, hits);
+    else circles_vs_box_sse2(x, y, radii, count, box_x, box_y, half_width, half_height, hits);
+#else
+    circles_vs_box_scalar(x, y, radii, 0, count, box_x, box_y, half_width, half_height, hits);
+#endif
+}
+
+const char* collision_kernel_name()
+{
+#ifdef COLLISION_X86
+    return has_avx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
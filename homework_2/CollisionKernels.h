@@ -0,0 +1,50 @@
+//
+//  CollisionKernels.h
+//  exercise
+//
+//  Batched circle-vs-box narrowphase over packed float arrays. Results are
+//  written as bitmasks: bit i of hits[i / 64] is set when pair i overlaps.
+//  Uses AVX2 when the CPU has it, SSE2 otherwise, and plain C++ on anything
+//  else; every path gives the same answer as circle_overlaps_box.
+//
+
+#pragma once
+
+#include <cstdint>
+
+// Words of bitmask needed to hold `count` results
+inline int hit_words(int count) { return (count + 63) / 64; }
+
+inline bool test_hit(const uint64_t* hits, int i) { return (hits[i / 64] >> (i % 64)) & 1; }
+
+// The scalar test everything else must agree with. x_distance and y_distance are the
+// absolute offsets between centres; compares squared distances so no sqrt is needed.
+inline bool circle_overlaps_box(float x_distance, float y_distance, float radius, float half_width, float half_height)
+{
+    if (x_distance > half_width + radius) { return false; }       // too far to collide
+    if (y_distance > half_height + radius) { return false; }
+
+    if (x_distance <= half_width) { return true; }                // edge collisions
+    if (y_distance <= half_height) { return true; }
+
+    float corner_x = x_distance - half_width;                     // circle centre to nearest corner
+    float corner_y = y_distance - half_height;
+    return corner_x * corner_x + corner_y * corner_y <= radius * radius;
+}
+
+// Time of impact, as a fraction of the step, of a circle starting at (x, y) and moving by
+// (move_x, move_y) against a box; -1 if it doesn't reach the box within the step or is
+// already touching it at the start.
+float sweep_circle_box(float x, float y, float move_x, float move_y, float radius,
+                       float box_x, float box_y, float half_width, float half_height);
+
+// One circle against `count` boxes (centres and half extents)
+void circle_vs_boxes(float x, float y, float radius,
+                     const float* box_x, const float* box_y, const float* half_widths, const float* half_heights,
+                     int count, uint64_t* hits);
+
+// `count` circles against one box
+void circles_vs_box(const float* x, const float* y, const float* radii, int count,
+                    float box_x, float box_y, float half_width, float half_height, uint64_t* hits);
+
+const char* collision_kernel_name();    // "avx2", "sse2" or "scalar", whichever is in use
@@ -0,0 +1,665 @@
+//
+//  EntityStore.cpp
+//  exercise
+//
+
+#define GL_SILENCE_DEPRECATION
+
+#ifndef HEADLESS
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "SpriteInstancer.h"
+#include "StreamBuffer.h"
+#include "RenderQueue.h"
+#endif
+
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "EntityStore.h"
+#include "CollisionKernels.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+
+EntityStore g_entity_store;
+
+EntityStore::EntityStore()
+{
+    positions.reserve(INITIAL_CAPACITY);
+    movements.reserve(INITIAL_CAPACITY);
+    speeds.reserve(INITIAL_CAPACITY);
+    scales.reserve(INITIAL_CAPACITY);
+    rotations.reserve(INITIAL_CAPACITY);
+    omegas.reserve(INITIAL_CAPACITY);
+    masses.reserve(INITIAL_CAPACITY);
+    shapes.reserve(INITIAL_CAPACITY);
+    flags.reserve(INITIAL_CAPACITY);
+
+    previous_positions.reserve(INITIAL_CAPACITY);
+    previous_rotations.reserve(INITIAL_CAPACITY);
+    model_matrices.reserve(INITIAL_CAPACITY);
+    sprites.reserve(INITIAL_CAPACITY);
+    current_animations.reserve(INITIAL_CAPACITY);
+    animation_indices.reserve(INITIAL_CAPACITY);
+    animation_frames.reserve(INITIAL_CAPACITY);
+    animation_times.reserve(INITIAL_CAPACITY);
+}
+
+int EntityStore::add_sprite(std::vector<SpriteFrame> regions, std::vector<std::vector<int>> animations,
+                            int cols, int rows)
+{
+    m_sprites.push_back({ regions, animations, cols, rows });
+    return (int) m_sprites.size() - 1;
+}
+
+int EntityStore::spawn(int sprite)
+{
+    int id;
+
+    if (!m_free_slots.empty()) {    // reuse a dead slot before growing
+        id = m_free_slots.back();
+        m_free_slots.pop_back();
+    }
+    else {
+        id = size();
+        positions.emplace_back();
+        movements.emplace_back();
+        speeds.emplace_back();
+        scales.emplace_back();
+        rotations.emplace_back();
+        omegas.emplace_back();
+        masses.emplace_back();
+        shapes.emplace_back();
+        flags.emplace_back();
+        previous_positions.emplace_back();
+        previous_rotations.emplace_back();
+        model_matrices.emplace_back();
+        sprites.emplace_back();
+        current_animations.emplace_back();
+        animation_indices.emplace_back();
+        animation_frames.emplace_back();
+        animation_times.emplace_back();
+    }
+
+    positions[id] = glm::vec3(0.0f);
+    movements[id] = glm::vec3(0.0f);
+    speeds[id]    = glm::vec3(0.0f);
+    scales[id]    = glm::vec3(1.0f, 1.0f, 0.0f);
+    rotations[id] = 0.0f;
+    omegas[id]    = 0.0f;
+    masses[id]    = 1.0f;
+    shapes[id]    = NO_SHAPE;
+    flags[id]     = ALIVE | VISIBLE | CAN_MOVE | MOVING | STALE;
+
+    previous_positions[id] = glm::vec3(0.0f);
+    previous_rotations[id] = 0.0f;
+    model_matrices[id]     = glm::mat4(1.0f);
+    sprites[id]            = sprite;
+    current_animations[id] = SPRITE1;
+    animation_indices[id]  = 0;
+    animation_frames[id]   = 0;
+    animation_times[id]    = 0.0f;
+
+    if (sprite >= 0) set_animation_state(id, SPRITE1);
+
+    m_live_count++;
+    return id;
+}
+
+void EntityStore::despawn(int id)
+{
+    if (!is(id, ALIVE)) return;
+
+    flags[id] = 0;
+    m_free_slots.push_back(id);
+    m_live_count--;
+}
+
+void EntityStore::clear()
+{
+    m_free_slots.clear();
+    m_sprites.clear();
+    m_live_count = 0;
+
+    positions.clear();
+    movements.clear();
+    speeds.clear();
+    scales.clear();
+    rotations.clear();
+    omegas.clear();
+    masses.clear();
+    shapes.clear();
+    flags.clear();
+
+    previous_positions.clear();
+    previous_rotations.clear();
+    model_matrices.clear();
+    sprites.clear();
+    current_animations.clear();
+    animation_indices.clear();
+    animation_frames.clear();
+    animation_times.clear();
+}
+
+bool EntityStore::check_collision(int id, int other) const {
+    if (is(other, VISIBLE)) {
+
+        float x_distance = fabs(positions[id].x - positions[other].x);
+        float y_distance = fabs(positions[id].y - positions[other].y);
+
+        if (shapes[id] == BALL) {      // if item is ball ... then things get complicated and annoying
+            return circle_overlaps_box(x_distance, y_distance, scales[id][0] / 2.0f,
+                                       scales[other][0] / 2.0f, scales[other][1] / 2.0f);
+        }
+
+        else {      // box to box
+            return (x_distance < (scales[id][0] + scales[other][0]) / 2.0f) && (y_distance < (scales[id][1] + scales[other][1]) / 2.0f);
+        }
+    }
+    return false;
+}
+
+void EntityStore::resolve_collision(int id, int other) {
+    glm::vec3& movement = movements[id];
+
+    if (shapes[id] == BALL) {     // side walls don't move the ball, the game rules hear about them from events
+        if (shapes[other] == LEFT_PADDLE) {  // ball collides with paddle
+            movement = glm::vec3(1.0f, movement[1], movement[2]);
+        }
+        else if (shapes[other] == RIGHT_PADDLE) {
+            movement = glm::vec3(-1.0f, movement[1], movement[2]);
+        }
+
+        else if (shapes[other] == TOP_WALL) {
+            movement = glm::vec3(movement[0], -1.0f, movement[2]);
+        }
+        else if (shapes[other] == BOTTOM_WALL) {
+            movement = glm::vec3(movement[0], 1.0f, movement[2]);
+        }
+    }
+    else if (shapes[id] == LEFT_PADDLE || shapes[id] == RIGHT_PADDLE) {  // paddle collides with wall
+
+        if (shapes[other] == TOP_WALL) {
+            movement = glm::vec3(1.0f, -1.0f, 1.0f);
+        }
+        else if (shapes[other] == BOTTOM_WALL) {
+            movement = glm::vec3(1.0f, 1.0f, 1.0f);
+        }
+    }
+}
+
+void EntityStore::animate(int id, float delta_time) {
+    animation_times[id] += delta_time;
+    float frames_per_second = 1.0f / SECONDS_PER_FRAME;
+
+    if (animation_times[id] >= frames_per_second) {
+        animation_times[id] = 0.0f;
+        animation_indices[id]++;
+
+        if (animation_indices[id] >= animation_frames[id]) {
+            animation_indices[id] = 0;
+        }
+    }
+
+    rotations[id] += omegas[id] * delta_time;
+}
+
+// Not moving, spinning or flipping through frames (walls, the backdrop, paused balls):
+// a step wouldn't change anything, so integrate skips it
+bool EntityStore::is_still(int id) const {
+    glm::vec3 velocity = movements[id] * speeds[id];
+    return velocity == glm::vec3(0.0f) && omegas[id] == 0.0f && animation_frames[id] <= 1;
+}
+
+void EntityStore::integrate(int id, float delta_time) {
+    if (skip_unchanged && is_still(id)) return;
+
+    touch(id);
+    animate(id, delta_time);
+    positions[id] += movements[id] * speeds[id] * delta_time;
+}
+
+// A ball moving less than its radius in a step gets caught by the overlap test before it
+// can pass through anything, so only faster ones pay for the sweep
+bool EntityStore::needs_sweep(int id, float delta_time) const {
+    if (!continuous_collisions || shapes[id] != BALL) return false;
+
+    glm::vec3 step = movements[id] * speeds[id] * delta_time;
+    return step.x * step.x + step.y * step.y > scales[id][0] * scales[id][0] / 4.0f;
+}
+
+// Moves to the earliest contact within the step, responds to it, then carries on with
+// whatever is left of the step in the new direction
+void EntityStore::integrate(int id, float delta_time, const std::vector<int>& collidables, Scratch& scratch) {
+    if (!needs_sweep(id, delta_time)) {
+        integrate(id, delta_time);
+        return;
+    }
+
+    touch(id);
+    animate(id, delta_time);
+    float remaining = 1.0f;
+
+    for (int sweep = 0; sweep < MAX_SWEEPS && remaining > 0.0f; sweep++) {
+        glm::vec3 step = movements[id] * speeds[id] * delta_time * remaining;
+        float earliest = 1.0f;
+        int contact = -1;
+
+        for (int other : collidables) {
+            if (other == id || !is(other, VISIBLE)) continue;
+
+            float t = sweep_circle_box(positions[id].x, positions[id].y, step.x, step.y, scales[id][0] / 2.0f,
+                                       positions[other].x, positions[other].y,
+                                       scales[other][0] / 2.0f, scales[other][1] / 2.0f);
+            if (t >= 0.0f && t < earliest) {
+                earliest = t;
+                contact = other;
+            }
+        }
+
+        positions[id] += step * earliest;
+        if (contact < 0) break;
+
+        resolve_collision(id, contact);     // only writes to the ball, so safe inside a job
+        scratch.swept.push_back({ id, contact });
+        remaining *= 1.0f - earliest;
+    }
+}
+
+// ————— PIPELINE ————— //
+// A batched update runs as separate stages, so each can be profiled (and vectorised) on
+// its own and the result doesn't depend on how many threads there are:
+//  - detect:    chunks of balls on g_jobs find what they overlap, into per-lane contact lists
+//  - respond:   the lists are merged and sorted, then every contact is resolved in order
+//  - integrate: chunks of balls move again on g_jobs, each only writing to its own slot;
+//               fast balls sweep and respond to what they meet on the way
+//  - emit:      every contact from the step goes onto the event ring, in sorted order
+// Game rules (who lost), sound and effects all read the ring rather than entity state.
+
+void EntityStore::prepare_scratch() {
+    if ((int) m_scratch.size() < g_jobs.lane_count()) m_scratch.resize(g_jobs.lane_count());
+}
+
+// Merges one list from every lane into m_contacts, sorted so lane timing can't reorder it
+void EntityStore::gather(std::vector<Contact> Scratch::* list) {
+    m_contacts.clear();
+    for (Scratch& scratch : m_scratch) {
+        std::vector<Contact>& contacts = scratch.*list;
+        m_contacts.insert(m_contacts.end(), contacts.begin(), contacts.end());
+        contacts.clear();
+    }
+    std::sort(m_contacts.begin(), m_contacts.end());
+}
+
+void EntityStore::respond() {
+    gather(&Scratch::contacts);
+
+    for (const Contact& contact : m_contacts) {
+        resolve_collision(contact.id, contact.other);
+        emit(contact);
+    }
+}
+
+void EntityStore::emit(const Contact& contact) {
+    CollisionEventType type;
+    switch (shapes[contact.other]) {
+        case LEFT_PADDLE:
+        case RIGHT_PADDLE: type = BALL_HIT_PADDLE;    break;
+        case SIDE_WALL:    type = BALL_HIT_SIDE_WALL; break;
+        case BALL:         type = BALL_HIT_BALL;      break;
+        default:           type = BALL_HIT_WALL;      break;
+    }
+
+    events.push({ type, contact.id, contact.other, positions[contact.id].x, positions[contact.id].y });
+}
+
+void EntityStore::emit_swept() {
+    gather(&Scratch::swept);
+    for (const Contact& contact : m_contacts) emit(contact);
+}
+
+void EntityStore::update(const std::vector<int>& ids, float delta_time, const std::vector<int>& collidables) {
+    if (collidables.size() >= BROADPHASE_MIN_COLLIDABLES) update_broadphase(ids, delta_time, collidables);
+    else update_brute_force(ids, delta_time, collidables);
+}
+
+// Every ball against every collidable, one SIMD pass over each job's balls per collidable
+// (or the scalar test, when there are too few balls for packing them to pay)
+void EntityStore::update_brute_force(const std::vector<int>& ids, float delta_time, const std::vector<int>& collidables) {
+    int count = (int) ids.size();
+    int words = hit_words(count);
+    bool packed = count >= SIMD_MIN_BALLS;
+
+    prepare_scratch();
+
+    if (packed) {
+        m_circle_x.resize(count);
+        m_circle_y.resize(count);
+        m_circle_radii.resize(count);
+        for (int i = 0; i < count; i++) {
+            m_circle_x[i] = positions[ids[i]].x;
+            m_circle_y[i] = positions[ids[i]].y;
+            m_circle_radii[i] = scales[ids[i]][0] / 2.0f;
+        }
+        m_hits.assign(collidables.size() * words, 0);
+    }
+
+    g_jobs.parallel_for(count, PARALLEL_GRAIN, [&](int begin, int end, int lane) {
+        Scratch& scratch = m_scratch[lane];
+
+        for (int c = 0; packed && c < (int) collidables.size(); c++) {
+            int other = collidables[c];
+            if (!is(other, VISIBLE)) continue;
+
+            circles_vs_box(&m_circle_x[begin], &m_circle_y[begin], &m_circle_radii[begin], end - begin,
+                           positions[other].x, positions[other].y, scales[other][0] / 2.0f, scales[other][1] / 2.0f,
+                           &m_hits[c * words + begin / 64]);
+        }
+
+        for (int i = begin; i < end; i++) {
+            int id = ids[i];
+            if (!is(id, VISIBLE)) continue;
+
+            bool use_hits = packed && shapes[id] == BALL;   // boxes take the scalar box-to-box test
+            for (int c = 0; c < (int) collidables.size(); c++) {
+                if (use_hits ? test_hit(&m_hits[c * words], i) : check_collision(id, collidables[c]))
+                    scratch.contacts.push_back({ id, collidables[c] });
+            }
+        }
+    });
+
+    respond();
+
+    g_jobs.parallel_for(count, PARALLEL_GRAIN, [&](int begin, int end, int lane) {
+        for (int i = begin; i < end; i++) {
+            if (is(ids[i], VISIBLE)) integrate(ids[i], delta_time, collidables, m_scratch[lane]);
+        }
+    });
+
+    emit_swept();
+}
+
+// Same as update_brute_force, but only pairs sharing a grid cell reach check_collision
+void EntityStore::update_broadphase(const std::vector<int>& ids, float delta_time, const std::vector<int>& collidables) {
+    m_broadphase.clear();
+    for (int other : collidables) {
+        if (is(other, VISIBLE)) m_broadphase.insert(other, positions[other], scales[other]);
+    }
+    m_broadphase.build();
+
+    prepare_scratch();
+
+    g_jobs.parallel_for((int) ids.size(), PARALLEL_GRAIN, [&](int begin, int end, int lane) {
+        Scratch& scratch = m_scratch[lane];
+
+        for (int i = begin; i < end; i++) {
+            int id = ids[i];
+            if (!is(id, VISIBLE)) continue;
+
+            scratch.candidates.clear();
+            m_broadphase.query(positions[id], scales[id], scratch.candidates, scratch.visited);
+
+            for (int other : scratch.candidates) {
+                if (other != id && check_collision(id, other)) scratch.contacts.push_back({ id, other });
+            }
+        }
+    });
+
+    respond();
+
+    g_jobs.parallel_for((int) ids.size(), PARALLEL_GRAIN, [&](int begin, int end, int lane) {
+        Scratch& scratch = m_scratch[lane];
+
+        for (int i = begin; i < end; i++) {
+            int id = ids[i];
+            if (!is(id, VISIBLE)) continue;
+
+            if (!needs_sweep(id, delta_time)) {
+                integrate(id, delta_time);
+                continue;
+            }
+
+            // widen the query to everything the ball passes over
+            glm::vec3 step = movements[id] * speeds[id] * delta_time;
+            scratch.candidates.clear();
+            m_broadphase.query(positions[id] + step / 2.0f, scales[id] + glm::abs(step), scratch.candidates, scratch.visited);
+            std::sort(scratch.candidates.begin(), scratch.candidates.end());    // ties go to the lowest id, as in brute force
+            integrate(id, delta_time, scratch.candidates, scratch);
+        }
+    });
+
+    emit_swept();
+}
+
+// Circle-circle contacts between balls. Each ball goes into the grid by its centre only
+// and queries out as far as it could reach the biggest ball; walking the grid's own order
+// keeps neighbouring balls' queries on the same buckets. Every pair is found against the
+// positions at the start of the pass, then bounced in id order.
+void EntityStore::collide_balls(const std::vector<int>& ids) {
+    if (ids.size() < 2) return;
+
+    float largest = 0.0f;
+    for (int id : ids) {
+        if (is(id, VISIBLE)) largest = glm::max(largest, scales[id][0]);
+    }
+    if (largest <= 0.0f) return;
+
+    m_ball_grid.clear();
+    m_ball_grid.set_cell_size(2.0f * largest);     // each query then spans 2x2 cells rather than 3x3
+    for (int id : ids) {
+        if (is(id, VISIBLE)) m_ball_grid.insert(id, positions[id], glm::vec3(0.0f));
+    }
+    m_ball_grid.build();
+
+    prepare_scratch();
+    const std::vector<int>& grid_ids = m_ball_grid.ids();
+
+    g_jobs.parallel_for((int) grid_ids.size(), PARALLEL_GRAIN, [&](int begin, int end, int lane) {
+        Scratch& scratch = m_scratch[lane];
+
+        for (int i = begin; i < end; i++) {
+            int id = grid_ids[i];
+
+            scratch.candidates.clear();
+            m_ball_grid.query(positions[id], scales[id] + glm::vec3(largest, largest, 0.0f),
+                              scratch.candidates, scratch.visited);
+
+            for (int other : scratch.candidates) {
+                if (other <= id) continue;      // each pair once
+
+                scratch.pairs_tested++;
+                float reach = (scales[id][0] + scales[other][0]) / 2.0f;
+                glm::vec3 offset = positions[other] - positions[id];
+
+                if (offset.x * offset.x + offset.y * offset.y < reach * reach) scratch.contacts.push_back({ id, other });
+            }
+        }
+    });
+
+    for (Scratch& scratch : m_scratch) {
+        ball_pairs_tested += scratch.pairs_tested;
+        scratch.pairs_tested = 0;
+    }
+    gather(&Scratch::contacts);
+
+    for (const Contact& contact : m_contacts) {
+        if (bounce_balls(contact.id, contact.other)) emit(contact);
+    }
+    ball_contacts += m_contacts.size();
+}
+
+// Bounces two touching balls off each other if they're closing: perfectly elastic along
+// the line between their centres, so heavier balls deflect less. Balls that already part
+// (e.g. freshly spawned on the same spot) are left to drift apart on their own; returns
+// whether they bounced.
+bool EntityStore::bounce_balls(int id, int other) {
+    glm::vec2 velocity = glm::vec2(movements[id] * speeds[id]);
+    glm::vec2 other_velocity = glm::vec2(movements[other] * speeds[other]);
+
+    glm::vec2 offset = glm::vec2(positions[other]) - glm::vec2(positions[id]);
+    float distance = glm::length(offset);
+    if (distance == 0.0f) return false;   // no line between them to bounce along
+
+    glm::vec2 normal = offset / distance;
+    float closing = glm::dot(velocity - other_velocity, normal);
+    if (closing <= 0.0f) return false;
+
+    touch(id);
+    touch(other);
+
+    float total_mass = masses[id] + masses[other];
+    float impulse = 2.0f * closing / total_mass;
+    velocity       -= normal * impulse * masses[other];
+    other_velocity += normal * impulse * masses[id];
+
+    // push them apart so the same contact isn't found again next step, lighter ball furthest
+    float overlap = (scales[id][0] + scales[other][0]) / 2.0f - distance;
+    positions[id]    -= glm::vec3(normal * overlap * masses[other] / total_mass, 0.0f);
+    positions[other] += glm::vec3(normal * overlap * masses[id] / total_mass, 0.0f);
+
+    // movement is a direction scaled per axis by speed, so convert back where speed allows
+    for (int axis = 0; axis < 2; axis++) {
+        if (speeds[id][axis] != 0.0f) movements[id][axis] = velocity[axis] / speeds[id][axis];
+        if (speeds[other][axis] != 0.0f) movements[other][axis] = other_velocity[axis] / speeds[other][axis];
+    }
+    return true;
+}
+
+// Called before every fixed step so rendering can blend between the last two steps.
+// Starts a new step for the dirty flags too: nothing has moved in it yet.
+void EntityStore::save_previous() {
+    previous_positions = positions;
+    previous_rotations = rotations;
+
+    for (uint8_t& flag : flags) flag &= ~MOVING;
+}
+
+// Builds the model matrices alpha of the way from the previous step to the current one.
+// Entities that moved in the last step are blended every frame; once they stop, one
+// more build puts them exactly where they are, and after that they're skipped.
+void EntityStore::interpolate(float alpha) {
+    for (int id = 0; id < size(); id++) {
+        if (!is(id, VISIBLE)) continue;
+        if (skip_unchanged && !is(id, STALE)) continue;
+
+        bool moving = is(id, MOVING);
+        glm::vec3 position = moving ? glm::mix(previous_positions[id], positions[id], alpha) : positions[id];
+        float rotation = moving ? glm::mix(previous_rotations[id], rotations[id], alpha) : rotations[id];
+
+        // translate * rotate about z * scale, written out rather than as three 4x4 products
+        float cos_r = cosf(rotation), sin_r = sinf(rotation);
+        glm::mat4& model_matrix = model_matrices[id];
+        model_matrix[0] = glm::vec4( cos_r * scales[id].x, sin_r * scales[id].x, 0.0f, 0.0f);
+        model_matrix[1] = glm::vec4(-sin_r * scales[id].y, cos_r * scales[id].y, 0.0f, 0.0f);
+        model_matrix[2] = glm::vec4(0.0f, 0.0f, scales[id].z, 0.0f);
+        model_matrix[3] = glm::vec4(position, 1.0f);
+
+        if (!moving) set(id, STALE, false);
+        transforms_built++;
+    }
+}
+
+void EntityStore::set_animation_state(int id, Animation new_animation) {
+    current_animations[id] = new_animation;
+    animation_frames[id] = (int) m_sprites[sprites[id]].animations[new_animation].size();
+}
+
+SpriteFrame EntityStore::sprite_frame(int id) const {
+    const SpriteSheet& sheet = m_sprites[sprites[id]];
+    const SpriteFrame& region = sheet.regions[current_animations[id]];
+
+    float width = region.width / (float) sheet.cols;
+    float height = region.height / (float) sheet.rows;
+
+    return { region.texture,
+             region.u + (float) (animation_indices[id] % sheet.cols) * width,
+             region.v + (float) (animation_indices[id] / sheet.cols) * height,
+             width,
+             height };
+}
+
+#ifndef HEADLESS
+// Render the appropriate texture and animation frame
+void EntityStore::draw_sprite_from_texture_atlas(int id, ShaderProgram* program) const {
+    SpriteFrame frame = sprite_frame(id);
+    GLuint current_texture = frame.texture;  // Get the right texture
+
+    float u_coord = frame.u;
+    float v_coord = frame.v;
+
+    float width = frame.width;
+    float height = frame.height;
+
+    float tex_coords[] = {
+        u_coord, v_coord + height, u_coord + width, v_coord + height, u_coord + width,
+        v_coord, u_coord, v_coord + height, u_coord + width, v_coord, u_coord, v_coord
+    };
+
+    float vertices[] = {
+        -0.5, -0.5, 0.5, -0.5,  0.5, 0.5,
+        -0.5, -0.5, 0.5,  0.5, -0.5, 0.5
+    };
+
+    program->use();
+    g_gl_state.bind_texture(current_texture);
+
+    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0,
+                          (const void*) g_stream_buffer.upload(vertices, sizeof(vertices)));
+    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0,
+                          (const void*) g_stream_buffer.upload(tex_coords, sizeof(tex_coords)));
+    g_gl_state.use_attributes(GLState::bit(program->get_position_attribute()) |
+                              GLState::bit(program->get_tex_coordinate_attribute()));
+
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+void EntityStore::render(int id, ShaderProgram* program) const {
+    if (is(id, VISIBLE)) {
+        program->set_model_matrix(model_matrices[id]);
+
+        if (sprites[id] >= 0) draw_sprite_from_texture_atlas(id, program);
+    }
+}
+
+void EntityStore::render(const std::vector<int>& ids, ShaderProgram* program) const {
+    for (int id : ids) render(id, program);
+}
+
+void EntityStore::render(int id, SpriteBatch& batch) const {
+    if (is(id, VISIBLE) && sprites[id] >= 0) {
+        SpriteFrame frame = sprite_frame(id);
+        batch.draw(frame.texture, model_matrices[id], frame.u, frame.v, frame.width, frame.height);
+    }
+}
+
+void EntityStore::render(const std::vector<int>& ids, SpriteBatch& batch) const {
+    for (int id : ids) render(id, batch);
+}
+
+void EntityStore::render(int id, SpriteInstancer& instancer) const {
+    if (is(id, VISIBLE) && sprites[id] >= 0) {
+        SpriteFrame frame = sprite_frame(id);
+        instancer.draw(frame.texture, model_matrices[id], frame.u, frame.v, frame.width, frame.height);
+    }
+}
+
+void EntityStore::render(const std::vector<int>& ids, SpriteInstancer& instancer) const {
+    for (int id : ids) render(id, instancer);
+}
+
+void EntityStore::render(int id, RenderList& list, RenderLayer layer, RenderPipeline pipeline) const {
+    if (is(id, VISIBLE) && sprites[id] >= 0) list.push(layer, pipeline, sprite_frame(id), model_matrices[id]);
+}
+
+void EntityStore::render(const std::vector<int>& ids, RenderList& list, RenderLayer layer,
+                         RenderPipeline pipeline) const {
+    for (int id : ids) render(id, list, layer, pipeline);
+}
+#endif
@@ -0,0 +1,187 @@
+//
+//  EntityStore.h
+//  exercise
+//
+//  Structure-of-arrays storage for every entity in the game. Entity is a thin
+//  handle over one slot in here; batched updates and renders walk the arrays
+//  directly so thousands of balls stay in linear memory.
+//
+
+#pragma once
+
+#ifdef HEADLESS
+    typedef unsigned int GLuint;    // the headless build has no GL headers at all
+#else
+    #ifdef _WINDOWS
+        #include <GL/glew.h>
+    #endif
+    #define GL_GLEXT_PROTOTYPES 1
+    #include <SDL_opengl.h>
+#endif
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "glm/mat4x4.hpp"
+#include "SpatialHash.h"
+#include "EventRing.h"
+
+class ShaderProgram;
+class SpriteBatch;
+class SpriteInstancer;
+class RenderList;
+
+enum Animation { SPRITE1, SPRITE2, SPRITE3 };
+enum Shape { BALL, TOP_WALL, BOTTOM_WALL, SIDE_WALL, LEFT_PADDLE, RIGHT_PADDLE, NO_SHAPE };
+enum EntityFlag { ALIVE = 1 << 0, VISIBLE = 1 << 1, CAN_MOVE = 1 << 2,
+                  MOVING = 1 << 3,      // position, rotation or scale changed during the current step
+                  STALE  = 1 << 4 };    // model matrix doesn't show the current position yet
+
+// Back to front. Sorting a RenderList never reorders layers, and keeps submission order
+// among commands with the same layer, pipeline and texture.
+enum RenderLayer { LAYER_SCENE, LAYER_FIELD, LAYER_BALLS, LAYER_PARTICLES, LAYER_GOALS, LAYER_MESSAGE };
+enum RenderPipeline { PIPELINE_BATCHED, PIPELINE_INSTANCED, PIPELINE_DISCO_FLOOR,   // SpriteBatch, SpriteInstancer, the floor shader
+                      PIPELINE_PARTICLES };                                         // or ParticleRenderer
+
+// Two entities found touching; id is the one that moves in response
+struct Contact {
+    int id, other;
+
+    bool operator<(const Contact& rhs) const { return id != rhs.id ? id < rhs.id : other < rhs.other; }
+};
+
+// A texture and a rectangle of it in texture coordinates: an atlas region, or the one
+// frame an entity shows right now
+struct SpriteFrame {
+    GLuint texture;
+    float u, v, width, height;
+};
+
+// Render data shared between every entity spawned from it (e.g. all balls use one sheet)
+struct SpriteSheet {
+    std::vector<SpriteFrame> regions;           // where each animation's cols x rows grid sits in the atlas
+    std::vector<std::vector<int>> animations;   // frame indices for each animation type
+    int cols, rows;
+};
+
+class EntityStore
+{
+private:
+    std::vector<int> m_free_slots;      // despawned slots, reused before the arrays grow
+    std::vector<SpriteSheet> m_sprites;
+    int m_live_count = 0;
+
+    SpatialHash m_broadphase;
+    SpatialHash m_ball_grid { 1.0f, 1 };    // balls only; cell size follows the biggest ball, buckets the ball count
+
+    // One per job lane, so chunks of a parallel pass never share buffers. Lane 0 is
+    // whichever thread made g_jobs, so only that thread may update the store.
+    struct Scratch {
+        std::vector<int> candidates;        // broadphase query results
+        SpatialHash::Visited visited;
+        std::vector<Contact> contacts;      // overlaps found by the detect stage
+        std::vector<Contact> swept;         // contacts met part way through a step, already responded to
+        long long pairs_tested = 0;
+    };
+    std::vector<Scratch> m_scratch;
+    std::vector<Contact> m_contacts;        // one stage's contacts from every lane, merged and sorted
+
+    std::vector<float> m_circle_x;      // balls packed for the SIMD narrowphase
+    std::vector<float> m_circle_y;
+    std::vector<float> m_circle_radii;
+    std::vector<uint64_t> m_hits;       // one bitmask row per collidable
+
+    void prepare_scratch();
+    void gather(std::vector<Contact> Scratch::* list);
+    void respond();
+    void emit(const Contact& contact);
+    void emit_swept();
+    void integrate(int id, float delta_time, const std::vector<int>& collidables, Scratch& scratch);
+
+public:
+    static constexpr int INITIAL_CAPACITY = 4096;
+    static constexpr int SECONDS_PER_FRAME = 6;
+    static constexpr int BROADPHASE_MIN_COLLIDABLES = 16;  // below this testing every pair is cheaper
+    static constexpr int SIMD_MIN_BALLS = 16;              // below this packing for the kernels costs more than it saves
+    static constexpr int MAX_SWEEPS = 4;                   // contacts resolved per ball per step
+    static constexpr int PARALLEL_GRAIN = 256;             // balls per job; a multiple of 64 so jobs own whole hit words
+
+    bool continuous_collisions = true;  // sweep fast balls so they can't tunnel through thin boxes
+    bool skip_unchanged = true;         // don't integrate still entities or rebuild unchanged matrices (off to compare)
+
+    long long ball_pairs_tested = 0;    // running totals from collide_balls
+    long long ball_contacts = 0;
+    long long transforms_built = 0;     // running total from interpolate
+
+    EventRing events;                   // every contact a ball makes, in a fixed order each step
+
+    // ————— HOT DATA ————— //  (read and written every update)
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> movements;
+    std::vector<glm::vec3> speeds;
+    std::vector<glm::vec3> scales;
+    std::vector<float> rotations;
+    std::vector<float> omegas;
+    std::vector<float> masses;          // only used between balls
+    std::vector<Shape> shapes;
+    std::vector<uint8_t> flags;         // EntityFlag bits
+
+    // ————— RENDER DATA ————— //
+    std::vector<glm::vec3> previous_positions;  // state at the start of the last fixed step,
+    std::vector<float> previous_rotations;      // blended with the current one when drawing
+    std::vector<glm::mat4> model_matrices;
+    std::vector<int> sprites;           // index into m_sprites, -1 for nothing to draw
+    std::vector<Animation> current_animations;
+    std::vector<int> animation_indices;
+    std::vector<int> animation_frames;
+    std::vector<float> animation_times;
+
+    EntityStore();
+
+    // ————— POOL ————— //
+    int add_sprite(std::vector<SpriteFrame> regions, std::vector<std::vector<int>> animations,
+                   int cols, int rows);
+    int spawn(int sprite = -1);
+    void despawn(int id);
+    void clear();
+
+    int size() const { return (int) positions.size(); }     // slots ever used, live or not
+    int live_count() const { return m_live_count; }
+
+    bool is(int id, EntityFlag flag) const { return flags[id] & flag; }
+    void set(int id, EntityFlag flag, bool on) { flags[id] = on ? (flags[id] | flag) : (flags[id] & ~flag); }
+
+    // Anything writing positions, rotations or scales outside the store calls this, or the
+    // old model matrix keeps being drawn
+    void touch(int id) { flags[id] |= MOVING | STALE; }
+
+    // ————— SIMULATION ————— //
+    bool check_collision(int id, int other) const;
+    void resolve_collision(int id, int other);
+    void animate(int id, float delta_time);
+    bool is_still(int id) const;
+    void integrate(int id, float delta_time);
+    bool needs_sweep(int id, float delta_time) const;
+    void collide_balls(const std::vector<int>& ids);
+    bool bounce_balls(int id, int other);
+    void update(const std::vector<int>& ids, float delta_time, const std::vector<int>& collidables);
+    void update_brute_force(const std::vector<int>& ids, float delta_time, const std::vector<int>& collidables);
+    void update_broadphase(const std::vector<int>& ids, float delta_time, const std::vector<int>& collidables);
+    void save_previous();
+    void interpolate(float alpha);
+
+    // ————— RENDERING ————— //
+    void set_animation_state(int id, Animation new_animation);
+    SpriteFrame sprite_frame(int id) const;
+    void draw_sprite_from_texture_atlas(int id, ShaderProgram* program) const;
+    void render(int id, ShaderProgram* program) const;
+    void render(const std::vector<int>& ids, ShaderProgram* program) const;
+    void render(int id, SpriteBatch& batch) const;
+    void render(const std::vector<int>& ids, SpriteBatch& batch) const;
+    void render(int id, SpriteInstancer& instancer) const;
+    void render(const std::vector<int>& ids, SpriteInstancer& instancer) const;
+    void render(int id, RenderList& list, RenderLayer layer, RenderPipeline pipeline = PIPELINE_BATCHED) const;
+    void render(const std::vector<int>& ids, RenderList& list, RenderLayer layer,
+                RenderPipeline pipeline = PIPELINE_BATCHED) const;
+};
+
+extern EntityStore g_entity_store;
@@ -0,0 +1,59 @@
+//
+//  EventRing.h
+//  exercise
+//
+//  Fixed-size ring of collision events. The simulation pushes onto it during
+//  each step; game rules, sound and effects each keep their own cursor and
+//  read whatever has arrived since. Nothing is ever allocated after
+//  construction: a reader that falls a whole ring behind loses the oldest
+//  events instead of holding up the writer.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+enum CollisionEventType { BALL_HIT_PADDLE, BALL_HIT_WALL, BALL_HIT_SIDE_WALL, BALL_HIT_BALL };
+
+struct CollisionEvent {
+    CollisionEventType type;
+    int id, other;          // id is always the ball
+    float x, y;             // where the ball was when it happened
+};
+
+class EventRing
+{
+private:
+    std::vector<CollisionEvent> m_events;
+    uint64_t m_mask;
+    uint64_t m_pushed = 0;  // every event ever pushed, so cursors never wrap
+
+public:
+    static constexpr int DEFAULT_CAPACITY = 8192;      // rounded up to a power of two
+
+    explicit EventRing(int capacity = DEFAULT_CAPACITY)
+    {
+        uint64_t size = 1;
+        while (size < (uint64_t) capacity) size <<= 1;
+
+        m_events.resize(size);
+        m_mask = size - 1;
+    }
+
+    void push(const CollisionEvent& event) { m_events[m_pushed++ & m_mask] = event; }
+
+    uint64_t cursor() const { return m_pushed; }    // where a new reader starts
+
+    // Calls handle(event) for everything pushed since `cursor` and moves it up to date.
+    // Returns how many events were overwritten before they could be read.
+    template <typename Handle>
+    uint64_t read(uint64_t& cursor, Handle handle) const
+    {
+        uint64_t oldest = m_pushed > m_mask ? m_pushed - m_mask - 1 : 0;
+        uint64_t missed = cursor < oldest ? oldest - cursor : 0;
+
+        for (cursor += missed; cursor < m_pushed; cursor++) handle(m_events[cursor & m_mask]);
+        return missed;
+    }
+};
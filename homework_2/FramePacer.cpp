@@ -0,0 +1,51 @@
+//
+//  FramePacer.cpp
+//  exercise
+//
+
+#include "FramePacer.h"
+#include <algorithm>
+#include <thread>
+
+void FramePacer::start(double frame_rate, bool limiting)
+{
+    m_period = frame_rate > 0.0 ? 1.0 / frame_rate : 0.0;
+    m_limiting = limiting && m_period > 0.0;
+    m_stats = Stats();
+
+    m_last_frame = Clock::now();
+    m_deadline = m_last_frame + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_period));
+}
+
+void FramePacer::wait()
+{
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_period));
+    Clock::time_point now = Clock::now();
+
+    if (m_period > 0.0) {
+        double late = std::chrono::duration<double>(now - m_deadline).count();
+        if (late > m_period * 0.25) m_stats.missed++;
+        m_stats.worst_late = std::max(m_stats.worst_late, late);
+
+        if (now >= m_deadline) {
+            m_deadline = now;       // start over from here; no rushing to catch up
+        }
+        else if (m_limiting) {
+            auto spin_time = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SPIN_TIME));
+            if (m_deadline - now > spin_time) std::this_thread::sleep_for(m_deadline - now - spin_time);
+            while (Clock::now() < m_deadline) std::this_thread::yield();
+            now = Clock::now();
+        }
+        m_deadline += period;
+    }
+
+    m_stats.frames++;
+    m_stats.total_time += std::chrono::duration<double>(now - m_last_frame).count();
+    m_last_frame = now;
+}
+
+void FramePacer::resync()
+{
+    m_last_frame = Clock::now();
+    m_deadline = m_last_frame + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_period));
+}
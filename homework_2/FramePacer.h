@@ -0,0 +1,52 @@
+//
+//  FramePacer.h
+//  exercise
+//
+//  Holds the main loop to a steady frame period. Each wait() sleeps until
+//  shortly before the next deadline, because sleeps overshoot by a timer
+//  tick or so, then spins out the rest for precision. Without a limit it
+//  only measures: with vsync on, the swap does the waiting and this just
+//  counts how often a frame came in late. A late frame starts the next
+//  period from when it arrived rather than rushing frames to catch up.
+//
+
+#pragma once
+
+#include <chrono>
+
+class FramePacer
+{
+public:
+    struct Stats {
+        long long frames = 0;
+        long long missed = 0;           // frames later than their deadline by over a quarter period
+        double worst_late = 0.0;        // seconds past the deadline, for the latest frame
+        double total_time = 0.0;        // seconds, so total_time / frames is the average period
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    double m_period = 0.0;              // seconds; 0 for no target at all
+    bool m_limiting = false;            // sleep to the deadline, or only measure against it
+    Clock::time_point m_deadline;
+    Clock::time_point m_last_frame;
+    Stats m_stats;
+
+public:
+    static constexpr double SPIN_TIME = 0.002;     // seconds before a deadline to stop sleeping and spin
+
+    // frame_rate of 0 turns pacing off. Restarts the deadlines and the stats.
+    void start(double frame_rate, bool limiting);
+
+    // At the end of each frame
+    void wait();
+
+    // After the loop stopped drawing for a while: the next deadline is a period from now,
+    // and the gap isn't counted as a late frame
+    void resync();
+
+    const Stats& stats() const { return m_stats; }
+    bool limiting() const { return m_limiting; }
+    double frame_rate() const { return m_period > 0.0 ? 1.0 / m_period : 0.0; }
+};
@@ -0,0 +1,357 @@
+//
+//  Game.cpp
+//  exercise
+//
+
+#include "Game.h"
+#include "glm/gtc/constants.hpp"
+#include <cmath>
+#include <cstdlib>
+
+// ————— VARIABLES ————— //
+GameState g_game_state;
+std::vector<int> ball_collidables;
+std::vector<Entity*> paddle_collidables;
+int g_ball_sprite;
+
+bool left_right;    // 0 = ball goes left to start, 1 = goes right
+bool down_up;       // 0 = ball goes down to start, 1 = goes up
+
+bool start = true;
+bool pause = true;
+std::vector<glm::vec3> preserve_ball_movements;
+uint64_t rules_cursor = 0;      // how far apply_game_rules has read g_entity_store.events
+
+bool single_player = false;
+bool game_over = false;
+
+// ————— GENERATE OBJECTS ————— //
+void initialize_game(const GameTextures& textures)
+{
+    std::vector<std::vector<int>> entity_animations = { {0}, {0}, {0} };
+    
+    g_game_state.message = new Entity(
+        textures.message,  // atlas region for each animation
+        glm::vec3(0.0f),     // translation speed
+        entity_animations,   // list of animation frames for each type of animation
+        0.0f,                // animation time
+        1,                   // number of frames for animation
+        0,                   // current frame index
+        1,                   // current animation col amount
+        1,                   // current animation row amount
+        SPRITE1              // current animation
+    );
+
+    g_game_state.scene = new Entity(
+        textures.scene,  // atlas region for each animation
+        glm::vec3(0.0f),     // translation speed
+        entity_animations,   // list of animation frames for each type of animation
+        0.0f,                // animation time
+        1,                   // number of frames for animation
+        0,                   // current frame index
+        1,                   // current animation col amount
+        1,                   // current animation row amount
+        SPRITE1              // current animation
+    );
+    
+    g_game_state.top_wall = new Entity(
+        textures.box,      // atlas region for each animation
+        glm::vec3(0.0f),        // translation speed
+        entity_animations,      // list of animation frames for each type of animation
+        0.0f,                   // animation time
+        1,                      // number of frames
+        0,                      // current frame index
+        1,                      // current animation col amount
+        1,                      // current animation row amount
+        SPRITE1                 // current animation
+    );
+    
+    g_game_state.bottom_wall = new Entity(
+        textures.box,      // atlas region for each animation
+        glm::vec3(0.0f),        // translation speed
+        entity_animations,      // list of animation frames for each type of animation
+        0.0f,                   // animation time
+        1,                      // number of frames
+        0,                      // current frame index
+        1,                      // current animation col amount
+        1,                      // current animation row amount
+        SPRITE1                 // current animation
+    );
+    
+    g_game_state.left_wall = new Entity(
+        textures.box,      // atlas region for each animation
+        glm::vec3(0.0f),        // translation speed
+        entity_animations,      // list of animation frames for each type of animation
+        0.0f,                   // animation time
+        1,                      // number of frames
+        0,                      // current frame index
+        1,                      // current animation col amount
+        1,                      // current animation row amount
+        SPRITE1                 // current animation
+    );
+    
+    g_game_state.right_wall = new Entity(
+        textures.box,      // atlas region for each animation
+        glm::vec3(0.0f),        // translation speed
+        entity_animations,      // list of animation frames for each type of animation
+        0.0f,                   // animation time
+        1,                      // number of frames
+        0,                      // current frame index
+        1,                      // current animation col amount
+        1,                      // current animation row amount
+        SPRITE1                 // current animation
+    );
+    
+    g_game_state.left_paddle = new Entity(
+        textures.box,            // atlas region for each animation
+        glm::vec3(0.0f, 1.0f, 0.0f),    // translation speed
+        entity_animations,              // list of animation frames for each type of animation
+        0.0f,                        // animation time
+        1,                           // number of frames
+        0,                           // current frame index
+        1,                           // current animation col amount
+        1,                           // current animation row amount
+        SPRITE1                      // current animation
+    );
+    
+    g_game_state.right_paddle = new Entity(
+        textures.box,            // atlas region for each animation
+        glm::vec3(0.0f, 1.0f, 0.0f),    // translation speed
+        entity_animations,              // list of animation frames for each type of animation
+        0.0f,                   // animation time
+        1,                      // number of frames
+        0,                      // current frame index
+        1,                      // current animation col amount
+        1,                      // current animation row amount
+        SPRITE1                 // current animation
+    );
+    
+    g_ball_sprite = g_entity_store.add_sprite(textures.ball, entity_animations, 1, 1);
+    
+    ball_collidables.push_back(g_game_state.top_wall->get_id());
+    ball_collidables.push_back(g_game_state.bottom_wall->get_id());
+    ball_collidables.push_back(g_game_state.left_paddle->get_id());
+    ball_collidables.push_back(g_game_state.right_paddle->get_id());
+    ball_collidables.push_back(g_game_state.left_wall->get_id());
+    ball_collidables.push_back(g_game_state.right_wall->get_id());
+    
+    paddle_collidables.push_back(g_game_state.top_wall);
+    paddle_collidables.push_back(g_game_state.bottom_wall);
+    
+    g_game_state.message->set_position(MESSAGE_LOCATION);
+    g_game_state.message->set_scale(MESSAGE_SCALE);
+    g_game_state.message->set_visibility(true);
+    
+    g_game_state.scene->set_position(SCENE_LOCATION);
+    g_game_state.scene->set_scale(SCENE_SCALE);
+    
+    g_game_state.top_wall->set_position(TOP_WALL_LOCATION);
+    g_game_state.top_wall->set_scale(TOP_WALL_SCALE);
+    g_game_state.top_wall->set_shape(TOP_WALL);
+    
+    g_game_state.bottom_wall->set_position(BOTTOM_WALL_LOCATION);
+    g_game_state.bottom_wall->set_scale(BOTTOM_WALL_SCALE);
+    g_game_state.bottom_wall->set_shape(BOTTOM_WALL);
+    
+    g_game_state.left_wall->set_position(LEFT_WALL_LOCATION);
+    g_game_state.left_wall->set_scale(LEFT_WALL_SCALE);
+    g_game_state.left_wall->set_shape(SIDE_WALL);
+    
+    g_game_state.right_wall->set_position(RIGHT_WALL_LOCATION);
+    g_game_state.right_wall->set_scale(RIGHT_WALL_SCALE);
+    g_game_state.right_wall->set_shape(SIDE_WALL);
+    
+    g_game_state.left_paddle->set_position(LEFT_PADDLE_LOCATION);
+    g_game_state.left_paddle->set_scale(LEFT_PADDLE_SCALE);
+    g_game_state.left_paddle->set_shape(LEFT_PADDLE);
+    g_game_state.left_paddle->set_speed(PADDLE_SPEED);
+    
+    g_game_state.right_paddle->set_position(RIGHT_PADDLE_LOCATION);
+    g_game_state.right_paddle->set_scale(RIGHT_PADDLE_SCALE);
+    g_game_state.right_paddle->set_shape(RIGHT_PADDLE);
+    g_game_state.right_paddle->set_speed(PADDLE_SPEED);
+    
+    spawn_ball(glm::vec3(0.0f));
+    
+    reset_game();
+}
+
+// Puts everything back where it was before the first serve
+void reset_game()
+{
+    set_ball_count(1);
+    
+    int ball = g_game_state.balls[0];
+    g_entity_store.positions[ball] = g_entity_store.previous_positions[ball] = BALL_LOCATION;
+    g_entity_store.movements[ball] = glm::vec3(0.0f);
+    g_entity_store.rotations[ball] = g_entity_store.previous_rotations[ball] = 0.0f;
+    g_entity_store.touch(ball);
+    
+    g_game_state.left_paddle->set_position(LEFT_PADDLE_LOCATION);
+    g_game_state.left_paddle->set_movement(glm::vec3(0.0f));
+    g_game_state.left_paddle->set_can_move(!single_player);
+    
+    g_game_state.right_paddle->set_position(RIGHT_PADDLE_LOCATION);
+    g_game_state.right_paddle->set_movement(glm::vec3(0.0f));
+    g_game_state.right_paddle->set_can_move(true);
+    
+    g_game_state.loser = nullptr;
+    rules_cursor = g_entity_store.events.cursor();  // nothing from the last game counts
+    
+    g_game_state.message->set_animation_state(SPRITE1);
+    g_game_state.message->set_visibility(true);
+    
+    start = true;
+    pause = true;
+    game_over = false;
+}
+
+bool start_game()
+{
+    if (!start) return false;
+    
+    g_game_state.message->set_visibility(false);  // hide start screen
+    float left_right = static_cast<float>((rand() % 2) == 0 ? -1.0 : 1.0);
+    float down_up = static_cast<float>((rand() % 2) == 0 ? -1.0 : 1.0);
+    g_entity_store.movements[g_game_state.balls[0]] = glm::vec3(left_right, down_up, 0.0f);
+    start = false;  // already started, can't start again until next game
+    return true;
+}
+
+void toggle_pause()
+{
+    if (pause) {
+        // preserve speed for unpause
+        preserve_ball_movements.clear();
+        for (int ball : g_game_state.balls) {
+            preserve_ball_movements.push_back(g_entity_store.movements[ball]);
+            g_entity_store.movements[ball] = glm::vec3(0.0f);   // halt paddles and ball
+        }
+        g_game_state.left_paddle->set_can_move(false);
+        g_game_state.right_paddle->set_can_move(false);
+        pause = false;  // already paused, can't pause again until resumed
+    }
+    
+    else {  // resume
+        for (int i = 0; i < (int) g_game_state.balls.size(); i++) {
+            g_entity_store.movements[g_game_state.balls[i]] =
+                i < (int) preserve_ball_movements.size() ? preserve_ball_movements[i] : glm::vec3(0.0f);
+        }
+        g_game_state.left_paddle->set_can_move(true);
+        g_game_state.right_paddle->set_can_move(true);
+        pause = true;   // next time we hit space we can pause again
+    }
+}
+
+bool game_idle()
+{
+    return start || !pause || game_over;    // pause is false while paused
+}
+
+void simulate(float delta_time)
+{
+    if (single_player) {
+        // the computer only plays while the ball's in play, so the start, pause and game over
+        // screens stand still and count as idle
+        if (game_idle()) {
+            g_game_state.left_paddle->set_movement(glm::vec3(0.0f));
+        }
+        else if (g_entity_store.positions[g_game_state.balls[0]][1] > g_game_state.left_paddle->get_position()[1]) {
+            g_game_state.left_paddle->set_movement(glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        else {
+            g_game_state.left_paddle->set_movement(glm::vec3(0.0f, -1.0f, 0.0f));
+        }
+//        g_game_state.left_paddle->set_movement(glm::vec3(0.0f, g_game_state.left_paddle->get_movement()[1], 0.0f));
+    }
+    
+    g_game_state.scene->update(delta_time);
+    g_game_state.top_wall->update(delta_time);
+    g_game_state.bottom_wall->update(delta_time);
+    g_game_state.left_paddle->update(delta_time, paddle_collidables, paddle_collidables.size());
+    g_game_state.right_paddle->update(delta_time, paddle_collidables, paddle_collidables.size());
+    g_entity_store.update(g_game_state.balls, delta_time, ball_collidables);
+    g_entity_store.collide_balls(g_game_state.balls);
+    g_game_state.left_wall->update(delta_time);
+    g_game_state.right_wall->update(delta_time);
+    g_game_state.message->update(delta_time);
+    
+    apply_game_rules();
+}
+
+// The first ball past a side wall ends the game
+void apply_game_rules()
+{
+    g_entity_store.events.read(rules_cursor, [](const CollisionEvent& event) {
+        if (event.type != BALL_HIT_SIDE_WALL || game_over) return;
+        
+        bool left_lost = event.other == g_game_state.left_wall->get_id();
+        g_game_state.loser = left_lost ? g_game_state.left_wall : g_game_state.right_wall;
+        g_game_state.message->set_animation_state(left_lost ? SPRITE3 : SPRITE2);
+        g_game_state.message->set_visibility(true);
+        game_over = true;
+    });
+}
+
+// ———— BALLS ———— //
+int spawn_ball(glm::vec3 movement, glm::vec3 position)
+{
+    int ball = g_entity_store.spawn(g_ball_sprite);
+    
+    g_entity_store.positions[ball] = g_entity_store.previous_positions[ball] = position;
+    g_entity_store.scales[ball]    = BALL_SCALE;
+    g_entity_store.masses[ball]    = BALL_SCALE.x * BALL_SCALE.x;
+    g_entity_store.shapes[ball]    = BALL;
+    g_entity_store.speeds[ball]    = BALL_SPEED;
+    g_entity_store.omegas[ball]    = BALL_OMEGAS[g_game_state.balls.size() % 3];
+    g_entity_store.movements[ball] = movement;
+    
+    g_game_state.balls.push_back(ball);
+    return ball;
+}
+
+void set_ball_count(int count)
+{
+    count = glm::clamp(count, 1, MAX_BALLS);
+    
+    while ((int) g_game_state.balls.size() > count) {
+        g_entity_store.despawn(g_game_state.balls.back());
+        g_game_state.balls.pop_back();
+    }
+    
+    glm::vec3 first_movement = g_entity_store.movements[g_game_state.balls[0]];
+    
+    while ((int) g_game_state.balls.size() < count) {
+        switch (g_game_state.balls.size()) {
+            case 1: spawn_ball(-1.5f * first_movement);
+                break;
+            case 2: spawn_ball(glm::vec3(-0.9f * first_movement[0], 1.25f * first_movement[1], 0.0f));
+                break;
+            default: {      // the rest scatter in random directions from random spots, not all piled on the centre
+                float angle = (float) rand() / (float) RAND_MAX * 2.0f * glm::pi<float>();
+                glm::vec3 position = glm::vec3(((float) rand() / (float) RAND_MAX - 0.5f) * BALL_SPAWN_AREA.x,
+                                               ((float) rand() / (float) RAND_MAX - 0.5f) * BALL_SPAWN_AREA.y, 0.0f);
+                spawn_ball(glm::length(first_movement) > 0.0f ? glm::vec3(cos(angle), sin(angle), 0.0f)
+                                                              : glm::vec3(0.0f), position);
+                break;
+            }
+        }
+    }
+}
+
+void shutdown_game()
+{
+    delete   g_game_state.scene;
+    delete   g_game_state.message;
+    delete   g_game_state.top_wall;
+    delete   g_game_state.bottom_wall;
+    delete   g_game_state.left_wall;
+    delete   g_game_state.right_wall;
+    delete   g_game_state.left_paddle;
+    delete   g_game_state.right_paddle;
+    for (int ball : g_game_state.balls) g_entity_store.despawn(ball);
+    g_game_state.balls.clear();
+    
+    ball_collidables.clear();
+    paddle_collidables.clear();
+}
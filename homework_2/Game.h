@@ -0,0 +1,88 @@
+//
+//  Game.h
+//  exercise
+//
+//  Pong rules and state, shared by the windowed game and the headless simulator.
+//  Nothing in here touches SDL or GL.
+//
+
+#pragma once
+
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "Entity.h"
+
+// ————— CONSTANTS ————— //
+constexpr float FIXED_TIMESTEP = 1.0f / 240.0f;    // physics always advances in steps of this size
+
+constexpr glm::vec3 SCENE_SCALE = glm::vec3(12.0f, 12.0f, 0.0f);
+constexpr glm::vec3 SCENE_LOCATION = glm::vec3(0.0f, 0.0f, 0.0f);
+
+constexpr glm::vec3 MESSAGE_SCALE = glm::vec3(10.0f, 10.0f, 0.0f);
+constexpr glm::vec3 MESSAGE_LOCATION = glm::vec3(0.0f, 0.0f, 0.0f);
+
+constexpr glm::vec3 TOP_WALL_SCALE = glm::vec3(12.0f, 1.0f, 0.0f);
+constexpr glm::vec3 TOP_WALL_LOCATION = glm::vec3(0.0f, 3.9f, 0.0f);
+
+constexpr glm::vec3 BOTTOM_WALL_SCALE = glm::vec3(12.0f, 1.0f, 0.0f);
+constexpr glm::vec3 BOTTOM_WALL_LOCATION = glm::vec3(0.0f, -3.9f, 0.0f);
+
+constexpr glm::vec3 LEFT_WALL_SCALE = glm::vec3(1.0f, 8.0f, 0.0f);
+constexpr glm::vec3 LEFT_WALL_LOCATION = glm::vec3(-6.0f, 0.0f, 0.0f);
+
+constexpr glm::vec3 RIGHT_WALL_SCALE = glm::vec3(1.0f, 8.0f, 0.0f);
+constexpr glm::vec3 RIGHT_WALL_LOCATION = glm::vec3(6.0f, 0.0f, 0.0f);
+
+constexpr glm::vec3 LEFT_PADDLE_SCALE = glm::vec3(0.25f, 1.0f, 0.0f);
+constexpr glm::vec3 LEFT_PADDLE_LOCATION = glm::vec3(-4.8f, 0.0f, 0.0f);
+
+constexpr glm::vec3 RIGHT_PADDLE_SCALE = glm::vec3(0.25f, 1.0f, 0.0f);
+constexpr glm::vec3 RIGHT_PADDLE_LOCATION = glm::vec3(4.8f, 0.0f, 0.0f);
+
+constexpr glm::vec3 BALL_SCALE = glm::vec3(0.75f, 0.75f, 0.0f);
+constexpr glm::vec3 BALL_LOCATION = glm::vec3(0.0f, 0.0f, 0.0f);
+constexpr glm::vec3 BALL_SPAWN_AREA = glm::vec3(8.0f, 5.0f, 0.0f);    // extra balls appear anywhere in here
+
+constexpr glm::vec3 PADDLE_SPEED = glm::vec3(0.0f, 2.0f, 0.0f);
+constexpr glm::vec3 BALL_SPEED = glm::vec3(3.0f, 0.50f, 0.0f);
+
+constexpr int MAX_BALLS = 16384;
+constexpr float BALL_OMEGAS[] = { 0.5f, -0.75f, 0.35f };     // spin for each new ball, cycled
+
+// ————— STRUCTS ————— //
+struct GameState {  Entity* scene;
+                    Entity* message;
+                    Entity* top_wall;
+                    Entity* bottom_wall;
+                    Entity* left_wall;
+                    Entity* right_wall;
+                    Entity* left_paddle;
+                    Entity* right_paddle;
+                    Entity* loser;              // the side wall a ball got past, once game_over
+                    std::vector<int> balls;     // slots in g_entity_store, balls[0] starts the rally
+};
+
+struct GameTextures {   // atlas regions, one per animation; left empty when nothing will be drawn
+    std::vector<SpriteFrame> message;
+    std::vector<SpriteFrame> scene;
+    std::vector<SpriteFrame> box;
+    std::vector<SpriteFrame> ball;
+};
+
+// ————— VARIABLES ————— //
+extern GameState g_game_state;
+extern bool single_player;
+extern bool game_over;
+
+// ————— FUNCTIONS ————— //
+void initialize_game(const GameTextures& textures);
+void reset_game();
+bool start_game();     // false once the game is already under way
+void toggle_pause();
+bool game_idle();      // on the start screen, paused, or over: only the players can make anything move
+void simulate(float delta_time);
+void apply_game_rules();
+void shutdown_game();
+
+int spawn_ball(glm::vec3 movement, glm::vec3 position = BALL_LOCATION);
+void set_ball_count(int count);
@@ -0,0 +1,112 @@
+//
+//  GpuTimer.cpp
+//  exercise
+//
+
+#ifndef HEADLESS
+#define GL_SILENCE_DEPRECATION
+
+#include "GpuTimer.h"
+#include "ShaderProgram.h"
+
+GpuTimer g_gpu_timer;
+
+void GpuTimer::load()
+{
+    // the EXT version is all older drivers and macOS's legacy contexts have; it has no timestamps
+    if (g_gl_lookup.extension_supported("GL_ARB_timer_query")) {
+        m_get_query_result = (GetQueryObjectProc) g_gl_lookup.proc_address("glGetQueryObjectui64v");
+        m_query_counter = (QueryCounterProc) g_gl_lookup.proc_address("glQueryCounter");
+    }
+    else if (g_gl_lookup.extension_supported("GL_EXT_timer_query")) {
+        m_get_query_result = (GetQueryObjectProc) g_gl_lookup.proc_address("glGetQueryObjectui64vEXT");
+    }
+    m_supported = m_get_query_result != nullptr;
+    m_timestamps = m_supported && m_query_counter != nullptr;
+}
+
+int GpuTimer::add_zone(const std::string& name)
+{
+    m_zones.push_back(Zone());
+    m_zones.back().name = name;
+    if (m_supported) glGenQueries(FRAMES_IN_FLIGHT * 2, &m_zones.back().queries[0][0]);
+    return (int) m_zones.size() - 1;
+}
+
+void GpuTimer::begin(int zone)
+{
+    Zone& timed = m_zones[zone];
+    if (!m_supported || timed.open) return;
+
+    if (m_timestamps) {
+        m_query_counter(timed.queries[m_frame][0], GL_TIMESTAMP);
+    }
+    else {
+        if (m_elapsed_open >= 0) return;
+        glBeginQuery(GL_TIME_ELAPSED, timed.queries[m_frame][0]);
+        m_elapsed_open = zone;
+    }
+    timed.open = true;
+}
+
+void GpuTimer::end(int zone)
+{
+    Zone& timed = m_zones[zone];
+    if (!timed.open) return;
+
+    if (m_timestamps) {
+        m_query_counter(timed.queries[m_frame][1], GL_TIMESTAMP);
+    }
+    else {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_elapsed_open = -1;
+    }
+    timed.open = false;
+    timed.issued[m_frame] = true;
+}
+
+void GpuTimer::collect(Zone& zone, int slot)
+{
+    if (!zone.issued[slot]) return;
+
+    // still not done after this many frames means the GPU is far behind; drop the sample
+    // rather than wait, and the queries are simply reused. The last query issued finishes last.
+    GLuint last = zone.queries[slot][m_timestamps ? 1 : 0];
+    GLint available = 0;
+    glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+    zone.issued[slot] = false;
+    if (!available) return;
+
+    GLuint64 nanoseconds = 0;
+    if (m_timestamps) {
+        GLuint64 start = 0, end = 0;
+        m_get_query_result(zone.queries[slot][0], GL_QUERY_RESULT, &start);
+        m_get_query_result(zone.queries[slot][1], GL_QUERY_RESULT, &end);
+        nanoseconds = end > start ? end - start : 0;
+    }
+    else {
+        m_get_query_result(last, GL_QUERY_RESULT, &nanoseconds);
+    }
+
+    double milliseconds = nanoseconds / 1.0e6;
+    zone.milliseconds = zone.measured ? zone.milliseconds + (milliseconds - zone.milliseconds) * SMOOTHING
+                                      : milliseconds;
+    zone.measured = true;
+}
+
+void GpuTimer::reset(int zone)
+{
+    Zone& timed = m_zones[zone];
+    for (bool& issued : timed.issued) issued = false;
+    timed.milliseconds = 0.0;
+    timed.measured = false;
+}
+
+void GpuTimer::end_frame()
+{
+    if (!m_supported) return;
+
+    m_frame = (m_frame + 1) % FRAMES_IN_FLIGHT;
+    for (Zone& zone : m_zones) collect(zone, m_frame);
+}
+#endif
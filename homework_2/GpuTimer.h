@@ -0,0 +1,92 @@
+//
+//  GpuTimer.h
+//  exercise
+//
+//  Measures how long the GPU spends on a stretch of GL calls. Each zone keeps
+//  its queries in a ring, one slot per frame in flight, and a slot's result
+//  is only read once GL says it's available, a few frames later, so timing
+//  never makes the CPU wait for the GPU. With ARB_timer_query a zone is a
+//  pair of GL_TIMESTAMP queries, so zones can nest and overlap; with only
+//  EXT_timer_query it's a GL_TIME_ELAPSED query, which can't, and a zone
+//  begun inside another just isn't timed. With neither, every zone reads 0.
+//  Everything here runs on the thread with the GL context.
+//
+
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <string>
+#include <vector>
+
+class GpuTimer
+{
+private:
+    static constexpr int FRAMES_IN_FLIGHT = 4;      // a frame's results are read when its slot comes round again
+    static constexpr double SMOOTHING = 0.1;        // weight of the newest frame in each average
+
+    struct Zone {
+        std::string name;
+        GLuint queries[FRAMES_IN_FLIGHT][2] = {};   // start and end timestamps, or just the elapsed time in [0]
+        bool issued[FRAMES_IN_FLIGHT] = {};
+        bool open = false;
+        double milliseconds = 0.0;                  // averaged over recent frames
+        bool measured = false;
+    };
+
+    std::vector<Zone> m_zones;
+    int m_frame = 0;                                // slot this frame's queries go in
+    int m_elapsed_open = -1;                        // zone with a GL_TIME_ELAPSED query running, if any
+    bool m_supported = false;
+    bool m_timestamps = false;
+
+    typedef void (APIENTRY *GetQueryObjectProc)(GLuint id, GLenum name, GLuint64* value);
+    typedef void (APIENTRY *QueryCounterProc)(GLuint id, GLenum target);
+    GetQueryObjectProc m_get_query_result = nullptr;
+    QueryCounterProc m_query_counter = nullptr;
+
+    void collect(Zone& zone, int slot);
+
+public:
+    // Times whatever's drawn while it's in scope
+    class Scope
+    {
+    private:
+        GpuTimer& m_timer;
+        int m_zone;
+
+    public:
+        Scope(GpuTimer& timer, int zone) : m_timer(timer), m_zone(zone) { m_timer.begin(m_zone); }
+        ~Scope() { m_timer.end(m_zone); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // Once there's a GL context
+    void load();
+
+    // After load(). Returns the zone's index, for begin() and end().
+    int add_zone(const std::string& name);
+
+    void begin(int zone);
+    void end(int zone);
+
+    // After the frame's last zone: reads whatever results are ready and moves to the next slot
+    void end_frame();
+
+    // Forgets the zone's average and drops its results still in flight, e.g. once what it
+    // times has changed so the old numbers don't apply
+    void reset(int zone);
+
+    bool supported() const { return m_supported; }
+    bool nests() const { return m_timestamps; }
+    int zone_count() const { return (int) m_zones.size(); }
+    const std::string& name(int zone) const { return m_zones[zone].name; }
+    bool measured(int zone) const { return m_zones[zone].measured; }
+    double milliseconds(int zone) const { return m_zones[zone].milliseconds; }
+};
+
+extern GpuTimer g_gpu_timer;
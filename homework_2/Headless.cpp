@@ -0,0 +1,121 @@
+//
+//  Headless.cpp
+//  exercise
+//
+
+#include "Headless.h"
+#include "Benchmark.h"
+#include "Game.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+constexpr float MAX_MATCH_SECONDS = 600.0f;
+
+// How far off a paddle may aim. Anything past half a paddle plus a ball radius
+// misses, so roughly one return in five goes past and matches actually end.
+constexpr float AIM_ERROR = 1.1f;
+
+// Stand-in for the keyboard: steer a paddle towards the ball plus its aim error
+void steer_paddle(Entity* paddle, float target_y)
+{
+    float offset = target_y - paddle->get_position()[1];
+
+    if (!paddle->get_can_move() || fabs(offset) < 0.05f)
+        paddle->set_movement(glm::vec3(0.0f));
+    else
+        paddle->set_movement(glm::vec3(0.0f, offset > 0.0f ? 1.0f : -1.0f, 0.0f));
+}
+
+HeadlessReport simulate_matches(int matches, unsigned int seed, int ball_count, float timestep)
+{
+    HeadlessReport report;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> aim(-AIM_ERROR, AIM_ERROR);
+    srand(seed);
+
+    initialize_game({});    // no textures: nothing is ever drawn
+
+    auto wall_start = std::chrono::steady_clock::now();
+
+    for (int match = 0; match < matches; match++) {
+        reset_game();
+        start_game();
+        set_ball_count(ball_count);
+
+        int ball = g_game_state.balls[0];
+        float left_aim = aim(rng), right_aim = aim(rng);
+        uint64_t event_cursor = g_entity_store.events.cursor();
+        std::vector<uint8_t> on_paddle(g_entity_store.positions.size()), was_on_paddle(on_paddle.size());
+        float clock = 0.0f;
+
+        while (!game_over && clock < MAX_MATCH_SECONDS) {
+            float ball_y = g_entity_store.positions[ball].y;
+            steer_paddle(g_game_state.left_paddle, ball_y + left_aim);
+            steer_paddle(g_game_state.right_paddle, ball_y + right_aim);
+
+            simulate(timestep);
+            clock += timestep;
+            report.steps++;
+
+            // a ball keeps touching a paddle for a step or two after it's sent back, so a return
+            // is only its first step on one; each, by any ball, re-rolls how well each side aims
+            on_paddle.swap(was_on_paddle);
+            std::fill(on_paddle.begin(), on_paddle.end(), 0);
+            g_entity_store.events.read(event_cursor, [&](const CollisionEvent& event) {
+                if (event.type != BALL_HIT_PADDLE) return;
+                on_paddle[event.id] = 1;
+                if (was_on_paddle[event.id]) return;
+
+                report.paddle_hits++;
+                left_aim = aim(rng);
+                right_aim = aim(rng);
+            });
+        }
+
+        report.matches++;
+        report.simulated_seconds += clock;
+
+        if (!game_over) report.unfinished++;
+        else if (g_game_state.loser == g_game_state.left_wall) report.right_wins++;
+        else report.left_wins++;
+    }
+
+    report.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    shutdown_game();
+    return report;
+}
+
+int run_headless(int argc, char* argv[])
+{
+    int matches = argc > 0 ? atoi(argv[0]) : 1000;
+    unsigned int seed = argc > 1 ? (unsigned int) strtoul(argv[1], nullptr, 10) : 1;
+    int ball_count = argc > 2 ? atoi(argv[2]) : 1;
+    float timestep = argc > 3 ? 1.0f / (float) atof(argv[3]) : FIXED_TIMESTEP;
+
+    HeadlessReport report = simulate_matches(matches, seed, ball_count, timestep);
+
+    std::cout << "headless: " << report.matches << " matches (left " << report.left_wins
+              << ", right " << report.right_wins << ", unfinished " << report.unfinished << "), "
+              << report.paddle_hits << " paddle hits\n";
+    std::cout << "          " << report.steps << " steps, " << report.simulated_seconds << " s simulated in "
+              << report.wall_seconds << " s wall ("
+              << report.matches / report.wall_seconds << " matches/s, "
+              << report.paddle_hits / report.wall_seconds << " rallies/s, "
+              << report.steps / report.wall_seconds << " steps/s)\n";
+
+    return report.unfinished == 0 ? 0 : 1;
+}
+
+#ifdef HEADLESS
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::string(argv[1]) == "--bench") return run_benchmarks(argc - 2, argv + 2);
+    return run_headless(argc - 1, argv + 1);
+}
+#endif
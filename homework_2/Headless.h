@@ -0,0 +1,27 @@
+//
+//  Headless.h
+//  exercise
+//
+//  Runs whole matches with no window, GL context or textures, driven by a
+//  synthetic clock, for balancing and regression sweeps on render-less machines.
+//
+//  Windowed build:  ./homework_2 --headless [matches] [seed] [balls] [step_hz]
+//  Headless build:  every .cpp except main.cpp and ShaderProgram.cpp, with -DHEADLESS
+//                   ./disco_pong_headless [matches] [seed] [balls] [step_hz]
+//
+
+#pragma once
+
+struct HeadlessReport {
+    int matches = 0;
+    int left_wins = 0;
+    int right_wins = 0;
+    int unfinished = 0;         // hit MAX_MATCH_SECONDS without anyone losing
+    long long steps = 0;
+    long long paddle_hits = 0;
+    double simulated_seconds = 0.0;
+    double wall_seconds = 0.0;
+};
+
+HeadlessReport simulate_matches(int matches, unsigned int seed, int ball_count, float timestep);
+int run_headless(int argc, char* argv[]);
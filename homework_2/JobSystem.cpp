@@ -0,0 +1,125 @@
+//
+//  JobSystem.cpp
+//  exercise
+//
+
+#include "JobSystem.h"
+#include <algorithm>
+
+JobSystem g_jobs;
+
+static thread_local int t_lane = 0;
+
+JobSystem::JobSystem(int worker_count) : m_owner(std::this_thread::get_id())
+{
+    start(worker_count);
+}
+
+JobSystem::~JobSystem()
+{
+    stop();
+}
+
+int JobSystem::default_worker_count()
+{
+    return std::max((int) std::thread::hardware_concurrency() - 1, 0);
+}
+
+int JobSystem::current_lane()
+{
+    return t_lane;
+}
+
+void JobSystem::start(int worker_count)
+{
+    m_stopping = false;
+    for (int lane = 0; lane <= worker_count; lane++) m_lanes.push_back(std::make_unique<Lane>());
+    for (int lane = 1; lane <= worker_count; lane++) m_workers.emplace_back(&JobSystem::work, this, lane);
+}
+
+void JobSystem::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& worker : m_workers) worker.join();
+    m_workers.clear();
+    m_lanes.clear();
+}
+
+void JobSystem::set_worker_count(int worker_count)
+{
+    stop();
+    start(std::max(worker_count, 0));
+}
+
+void JobSystem::submit(Job job, Counter& counter)
+{
+    assert(t_lane != 0 || std::this_thread::get_id() == m_owner);
+    counter++;
+
+    Lane& lane = *m_lanes[t_lane % lane_count()];
+    {
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        lane.jobs.push_back({ std::move(job), &counter });
+    }
+    m_queued++;
+
+    // taking the lock orders this against a worker that has just found nothing queued and
+    // is about to sleep, so it can't miss the wake-up
+    { std::lock_guard<std::mutex> lock(m_sleep_mutex); }
+    m_wake.notify_one();
+}
+
+// Newest job from our own queue, otherwise the oldest from someone else's
+bool JobSystem::run_one(int lane)
+{
+    Queued queued;
+    bool found = false;
+
+    for (int i = 0; i < lane_count() && !found; i++) {
+        Lane& victim = *m_lanes[(lane + i) % lane_count()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.jobs.empty()) continue;
+
+        if (i == 0) {
+            queued = std::move(victim.jobs.back());
+            victim.jobs.pop_back();
+        }
+        else {
+            queued = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+        m_queued--;
+        found = true;
+    }
+
+    if (!found) return false;
+
+    queued.job();
+    (*queued.counter)--;
+    return true;
+}
+
+void JobSystem::wait(Counter& counter)
+{
+    while (counter > 0) {
+        if (!run_one(t_lane % lane_count())) std::this_thread::yield();
+    }
+}
+
+void JobSystem::work(int lane)
+{
+    t_lane = lane;
+
+    while (true) {
+        if (run_one(lane)) continue;
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_wake.wait(lock, [this] { return m_stopping || m_queued > 0; });
+        if (m_stopping && m_queued == 0) return;
+    }
+}
@@ -0,0 +1,96 @@
+//
+//  JobSystem.h
+//  exercise
+//
+//  Work-stealing thread pool. Every thread taking part (the workers, plus
+//  whichever thread calls in, which is lane 0) owns a lane with its own job
+//  queue: the owner pushes and pops at the back, idle lanes steal from the
+//  front of everyone else's. Waiting for jobs runs queued jobs instead of
+//  blocking, so it's fine to submit and wait from inside a job. Lane 0 is
+//  only one thread, though: the one that made the pool (the main thread for
+//  g_jobs) is the only non-worker that may call in.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem
+{
+public:
+    typedef std::function<void()> Job;
+    typedef std::atomic<int> Counter;   // jobs submitted against it and not finished yet
+
+private:
+    struct Queued { Job job; Counter* counter; };
+    struct Lane {
+        std::mutex mutex;
+        std::deque<Queued> jobs;
+    };
+
+    std::vector<std::unique_ptr<Lane>> m_lanes;
+    std::vector<std::thread> m_workers;
+    std::thread::id m_owner;            // the thread that made the pool, which calls in as lane 0
+
+    std::mutex m_sleep_mutex;           // idle workers sleep on m_wake until something is queued
+    std::condition_variable m_wake;
+    std::atomic<int> m_queued { 0 };
+    bool m_stopping = false;
+
+    bool run_one(int lane);
+    void work(int lane);
+    void start(int worker_count);
+    void stop();
+
+public:
+    explicit JobSystem(int worker_count = default_worker_count());
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    static int default_worker_count();  // one per core, leaving one for the calling thread
+    static int current_lane();          // 0 on any thread that isn't a worker, so only one of those may call in
+
+    // Only while nothing is queued or running, e.g. to check results don't depend on it
+    void set_worker_count(int worker_count);
+    int lane_count() const { return (int) m_lanes.size(); }
+
+    void submit(Job job, Counter& counter);
+    void wait(Counter& counter);
+
+    // Calls body(begin, end, lane) over [0, count) in chunks of `grain`, with the calling
+    // thread taking the first chunk. No two bodies running at once share a lane, so the
+    // lane can index per-thread scratch. Chunks may finish in any order.
+    template <typename Body>
+    void parallel_for(int count, int grain, const Body& body)
+    {
+        assert(current_lane() != 0 || std::this_thread::get_id() == m_owner);
+        if (count <= 0) return;
+
+        if (lane_count() == 1 || count <= grain) {
+            body(0, count, current_lane());
+            return;
+        }
+
+        Counter pending { 0 };
+        for (int begin = grain; begin < count; begin += grain) {
+            int end = std::min(begin + grain, count);
+            submit([&body, begin, end] { body(begin, end, current_lane()); }, pending);
+        }
+
+        body(0, grain, current_lane());
+        wait(pending);
+    }
+};
+
+extern JobSystem g_jobs;
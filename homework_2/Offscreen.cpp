@@ -0,0 +1,123 @@
+//
+//  Offscreen.cpp
+//  exercise
+//
+
+#ifdef OFFSCREEN
+#define GL_SILENCE_DEPRECATION
+
+#include "Offscreen.h"
+#include "ShaderProgram.h"
+#include <EGL/eglext.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+OffscreenContext g_offscreen;
+
+// SDL_GL_ExtensionSupported and SDL_GL_GetProcAddress answer nothing without SDL's video
+// subsystem, which offscreen runs never start. The context is desktop GL 3.0 or later.
+static bool egl_extension_supported(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        if (strcmp((const char*) glGetStringi(GL_EXTENSIONS, i), name) == 0) return true;
+    }
+    return false;
+}
+
+static void* egl_proc_address(const char* name)
+{
+    return (void*) eglGetProcAddress(name);
+}
+
+bool OffscreenContext::create(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+
+    // Mesa's surfaceless platform needs no X server or DRM device; elsewhere take the default
+    auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display) {
+        m_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (m_display == EGL_NO_DISPLAY) m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, nullptr, nullptr)) {
+        std::cerr << "Error: no EGL display (0x" << std::hex << eglGetError() << std::dec << ")\n";
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "Error: EGL can't create desktop GL contexts\n";
+        return false;
+    }
+
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, 0,        // never draws to an EGL surface, only the framebuffer below
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_count = 0;
+    eglChooseConfig(m_display, config_attributes, &config, 1, &config_count);
+
+    if (config_count > 0) m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, nullptr);
+    if (m_context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+        std::cerr << "Error: couldn't make a surfaceless GL context (0x" << std::hex << eglGetError()
+                  << std::dec << ")\n";
+        return false;
+    }
+
+    glGenRenderbuffers(1, &m_colour_buffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colour_buffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colour_buffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error: offscreen framebuffer is incomplete\n";
+        return false;
+    }
+
+    g_gl_lookup = { egl_extension_supported, egl_proc_address };
+
+    std::cout << "offscreen: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << "\n";
+    return true;
+}
+
+void OffscreenContext::destroy()
+{
+    if (m_display == EGL_NO_DISPLAY) return;
+
+    if (m_context != EGL_NO_CONTEXT) eglDestroyContext(m_display, m_context);
+    eglTerminate(m_display);
+    m_display = EGL_NO_DISPLAY;
+    m_context = EGL_NO_CONTEXT;
+}
+
+void OffscreenContext::make_current(bool current)
+{
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, current ? m_context : EGL_NO_CONTEXT);
+}
+
+bool OffscreenContext::dump(const std::string& path) const
+{
+    std::vector<unsigned char> pixels((size_t) m_width * m_height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    // GL's first row is the bottom one
+    fprintf(file, "P6\n%d %d\n255\n", m_width, m_height);
+    for (int row = m_height - 1; row >= 0; row--) fwrite(&pixels[(size_t) row * m_width * 3], 1, (size_t) m_width * 3, file);
+
+    return fclose(file) == 0;
+}
+#endif
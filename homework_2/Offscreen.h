@@ -0,0 +1,47 @@
+//
+//  Offscreen.h
+//  exercise
+//
+//  A GL context with no window, display or GPU behind it, for measuring render
+//  cost in containers. The context comes from EGL on Mesa's surfaceless
+//  platform (llvmpipe when there's no GPU) and draws into a framebuffer object
+//  the size a window would have been. Only built with -DOFFSCREEN, linking
+//  -lEGL; see run_offscreen() in main.cpp.
+//
+
+#pragma once
+
+#ifdef OFFSCREEN
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <EGL/egl.h>
+#include <string>
+
+class OffscreenContext
+{
+private:
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    GLuint m_framebuffer = 0;
+    GLuint m_colour_buffer = 0;
+    int m_width = 0, m_height = 0;
+
+public:
+    // Leaves the context current with the framebuffer bound. Prints why and returns
+    // false if there's no usable EGL.
+    bool create(int width, int height);
+    void destroy();
+
+    void make_current(bool current);
+
+    // Reads back the framebuffer as a binary PPM, top row first
+    bool dump(const std::string& path) const;
+};
+
+extern OffscreenContext g_offscreen;
+
+#endif
@@ -0,0 +1,55 @@
+//
+//  ParticleRenderer.cpp
+//  exercise
+//
+
+#ifndef HEADLESS
+#define GL_SILENCE_DEPRECATION
+
+#include "ParticleRenderer.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include <cstddef>
+
+void ParticleRenderer::load(ShaderProgram* program)
+{
+    m_program = program;
+
+    static const float QUAD[] = {
+        -0.5f, -0.5f, 0.5f, -0.5f,  0.5f, 0.5f,
+        -0.5f, -0.5f, 0.5f,  0.5f, -0.5f, 0.5f
+    };
+
+    glGenBuffers(1, &m_quad_buffer);
+    g_gl_state.bind_array_buffer(m_quad_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+
+    GLuint program_id = m_program->get_program_id();
+    m_particle_attribute        = glGetAttribLocation(program_id, "particle");
+    m_particle_colour_attribute = glGetAttribLocation(program_id, "particleColour");
+}
+
+void ParticleRenderer::draw(const std::vector<ParticleSystem::Instance>& particles)
+{
+    if (particles.empty()) return;
+
+    GLuint position = m_program->get_position_attribute();
+
+    m_program->use();
+
+    g_gl_state.bind_array_buffer(m_quad_buffer);
+    glVertexAttribPointer(position, 2, GL_FLOAT, false, 0, nullptr);
+
+    size_t base = g_stream_buffer.upload(particles.data(), particles.size() * sizeof(ParticleSystem::Instance));
+    glVertexAttribPointer(m_particle_attribute, 3, GL_FLOAT, false, sizeof(ParticleSystem::Instance),
+                          (const void*) (base + offsetof(ParticleSystem::Instance, x)));
+    glVertexAttribPointer(m_particle_colour_attribute, 4, GL_UNSIGNED_BYTE, true, sizeof(ParticleSystem::Instance),
+                          (const void*) (base + offsetof(ParticleSystem::Instance, colour)));
+    g_gl_state.use_attributes(GLState::bit(position),
+                              GLState::bit(m_particle_attribute) | GLState::bit(m_particle_colour_attribute));
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    g_gl_state.draw_arrays_instanced(GL_TRIANGLES, 0, 6, (GLsizei) particles.size());
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+#endif
@@ -0,0 +1,40 @@
+//
+//  ParticleRenderer.h
+//  exercise
+//
+//  Draws every live particle in one glDrawArraysInstanced call: a static unit
+//  quad, plus one ParticleSystem::Instance per particle uploaded through
+//  g_stream_buffer. Each quad is shaded as a soft round glow and blended
+//  additively, so overlapping sparkles brighten instead of covering each
+//  other. Needs its own program (shaders/vertex_particle.glsl and
+//  shaders/fragment_particle.glsl).
+//
+
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <vector>
+#include "ParticleSystem.h"
+
+class ShaderProgram;
+
+class ParticleRenderer
+{
+private:
+    ShaderProgram* m_program = nullptr;
+    GLuint m_quad_buffer = 0;
+
+    GLint m_particle_attribute;
+    GLint m_particle_colour_attribute;
+
+public:
+    // Once there's a GL context with instancing (g_gl_state.instancing())
+    void load(ShaderProgram* program);
+
+    // Leaves blending as SpriteBatch and SpriteInstancer expect it
+    void draw(const std::vector<ParticleSystem::Instance>& particles);
+};
@@ -0,0 +1,162 @@
+//
+//  ParticleSystem.cpp
+//  exercise
+//
+
+#include "ParticleSystem.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PARTICLES_X86 1
+    #include <immintrin.h>
+#endif
+
+ParticleSystem g_particles;
+
+constexpr float PARTICLE_LIFETIME = 0.8f;       // seconds, for the longest-lived
+constexpr float PARTICLE_SIZE     = 0.15f;      // world units, for the largest
+constexpr float PARTICLE_DRAG     = 0.15f;      // fraction of its speed a particle keeps after a second
+constexpr float PARTICLE_GRAVITY  = 1.5f;
+
+constexpr float PI = 3.14159265358979f;
+
+constexpr int PADDLE_BURST = 48,
+              WALL_BURST   = 24;
+
+constexpr float PADDLE_BURST_SPEED = 3.0f,
+                WALL_BURST_SPEED   = 2.0f;
+
+// The floor's colours plus white, as RGBA bytes with the alpha left for pack()
+static const uint32_t PALETTE[] = {
+    0x00e02eb5,     // purple
+    0x002b14e8,     // red
+    0x00f5e808,     // cyan
+    0x00f22e05,     // blue
+    0x002bd9fc,     // yellow
+    0x004dfa59,     // green
+    0x00ffffff,     // white
+};
+
+ParticleSystem::ParticleSystem(int capacity)
+{
+    for (std::vector<float>* array : { &m_x, &m_y, &m_velocity_x, &m_velocity_y, &m_life, &m_decay, &m_size }) {
+        array->resize(capacity);
+    }
+    m_colour.resize(capacity);
+}
+
+float ParticleSystem::random()
+{
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return (float) (m_random >> 8) / 16777216.0f;
+}
+
+void ParticleSystem::burst(float x, float y, int count, float speed)
+{
+    count = std::min(count, capacity() - m_count);      // a full pool drops the rest
+
+    for (int i = m_count; i < m_count + count; i++) {
+        float angle = random() * 2.0f * PI;
+        float launch = speed * (0.3f + 0.7f * random());
+
+        m_x[i] = x;
+        m_y[i] = y;
+        m_velocity_x[i] = cosf(angle) * launch;
+        m_velocity_y[i] = sinf(angle) * launch;
+        m_life[i]  = 1.0f;
+        m_decay[i] = 1.0f / (PARTICLE_LIFETIME * (0.5f + 0.5f * random()));
+        m_size[i]  = PARTICLE_SIZE * (0.5f + 0.5f * random());
+        m_colour[i] = PALETTE[(int) (random() * (sizeof(PALETTE) / sizeof(PALETTE[0])))];
+    }
+    m_count += count;
+}
+
+void ParticleSystem::spawn_from(const EventRing& events)
+{
+    events.read(m_event_cursor, [this](const CollisionEvent& event) {
+        switch (event.type) {
+            case BALL_HIT_PADDLE: burst(event.x, event.y, PADDLE_BURST, PADDLE_BURST_SPEED); break;
+            case BALL_HIT_WALL:   burst(event.x, event.y, WALL_BURST, WALL_BURST_SPEED);     break;
+            default: break;     // a ball in a goal touches it every step, and balls meet too often
+        }
+    });
+}
+
+// ————— INTEGRATION ————— //
+// drag is the factor velocities are scaled by this step and fall what gravity takes off vy
+static void integrate_scalar(float* x, float* y, float* velocity_x, float* velocity_y, float* life, const float* decay,
+                             int first, int count, float delta_time, float drag, float fall)
+{
+    for (int i = first; i < count; i++) {
+        x[i] += velocity_x[i] * delta_time;
+        y[i] += velocity_y[i] * delta_time;
+        velocity_x[i] *= drag;
+        velocity_y[i] = velocity_y[i] * drag - fall;
+        life[i] -= decay[i] * delta_time;
+    }
+}
+
+#ifdef PARTICLES_X86
+// SSE2 is always there on x86-64; this loop is bound by memory, so wider vectors buy nothing
+static void integrate_sse2(float* x, float* y, float* velocity_x, float* velocity_y, float* life, const float* decay,
+                           int count, float delta_time, float drag, float fall)
+{
+    __m128 dt = _mm_set1_ps(delta_time), d = _mm_set1_ps(drag), f = _mm_set1_ps(fall);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(velocity_x + i), vy = _mm_loadu_ps(velocity_y + i);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(vx, dt)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(vy, dt)));
+        _mm_storeu_ps(velocity_x + i, _mm_mul_ps(vx, d));
+        _mm_storeu_ps(velocity_y + i, _mm_sub_ps(_mm_mul_ps(vy, d), f));
+        _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), _mm_mul_ps(_mm_loadu_ps(decay + i), dt)));
+    }
+    integrate_scalar(x, y, velocity_x, velocity_y, life, decay, i, count, delta_time, drag, fall);
+}
+#endif
+
+void ParticleSystem::update(float delta_time)
+{
+    float drag = powf(PARTICLE_DRAG, delta_time);
+    float fall = PARTICLE_GRAVITY * delta_time;
+
+#ifdef PARTICLES_X86
+    integrate_sse2(m_x.data(), m_y.data(), m_velocity_x.data(), m_velocity_y.data(), m_life.data(), m_decay.data(),
+                   m_count, delta_time, drag, fall);
+#else
+    integrate_scalar(m_x.data(), m_y.data(), m_velocity_x.data(), m_velocity_y.data(), m_life.data(), m_decay.data(),
+                     0, m_count, delta_time, drag, fall);
+#endif
+
+    // the last live particle takes each dead one's place; it's checked again in its new spot
+    for (int i = 0; i < m_count;) {
+        if (m_life[i] > 0.0f) { i++; continue; }
+
+        int last = --m_count;
+        m_x[i] = m_x[last];
+        m_y[i] = m_y[last];
+        m_velocity_x[i] = m_velocity_x[last];
+        m_velocity_y[i] = m_velocity_y[last];
+        m_life[i]   = m_life[last];
+        m_decay[i]  = m_decay[last];
+        m_size[i]   = m_size[last];
+        m_colour[i] = m_colour[last];
+    }
+}
+
+void ParticleSystem::pack(std::vector<Instance>& instances) const
+{
+    size_t first = instances.size();
+    instances.resize(first + m_count);
+    Instance* out = instances.data() + first;
+
+    for (int i = 0; i < m_count; i++) {
+        float life = m_life[i];
+        out[i] = { m_x[i], m_y[i], m_size[i] * (0.5f + 0.5f * life),
+                   m_colour[i] | (uint32_t) (life * 255.0f) << 24 };     // shrinks and fades as it dies
+    }
+}
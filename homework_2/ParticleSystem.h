@@ -0,0 +1,65 @@
+//
+//  ParticleSystem.h
+//  exercise
+//
+//  Sparkles thrown off wherever a ball hits a paddle or a wall. Particles live
+//  in a fixed-capacity structure-of-arrays pool: spawning never allocates, a
+//  full pool drops whatever doesn't fit, and a dead particle is replaced by
+//  the last live one so the live ones are always [0, count()). Bursts come
+//  from the collision events in g_entity_store.events, read with a cursor of
+//  our own. Purely visual, so it steps once per rendered frame rather than at
+//  the fixed simulation rate, and needs no GL.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "EventRing.h"
+
+class ParticleSystem
+{
+public:
+    // One live particle as the renderer wants it: centre, size, and RGBA bytes (in
+    // that order in memory) with the alpha fading out over its life
+    struct Instance {
+        float x, y, size;
+        uint32_t colour;
+    };
+
+private:
+    std::vector<float> m_x, m_y;
+    std::vector<float> m_velocity_x, m_velocity_y;
+    std::vector<float> m_life;          // 1 when spawned, dead at 0
+    std::vector<float> m_decay;         // life lost per second
+    std::vector<float> m_size;
+    std::vector<uint32_t> m_colour;
+    int m_count = 0;
+
+    uint64_t m_event_cursor = 0;
+    uint32_t m_random = 2463534242u;    // xorshift state, so runs repeat exactly
+
+    float random();                     // in [0, 1)
+
+public:
+    static constexpr int DEFAULT_CAPACITY = 131072;
+
+    explicit ParticleSystem(int capacity = DEFAULT_CAPACITY);
+
+    // Up to count particles flying out of (x, y) in every direction
+    void burst(float x, float y, int count, float speed);
+
+    // A burst for every paddle and wall contact pushed since the last call
+    void spawn_from(const EventRing& events);
+
+    // Moves, slows, drops and ages every particle, then removes the dead ones
+    void update(float delta_time);
+
+    void pack(std::vector<Instance>& instances) const;  // appends every live particle
+    void clear() { m_count = 0; }
+
+    int count() const { return m_count; }
+    int capacity() const { return (int) m_x.size(); }
+};
+
+extern ParticleSystem g_particles;
@@ -0,0 +1,147 @@
+//
+//  RenderQueue.cpp
+//  exercise
+//
+
+#ifndef HEADLESS
+#define GL_SILENCE_DEPRECATION
+
+#include "RenderQueue.h"
+#include <cstring>
+
+RenderThread g_render_thread;
+
+glm::mat4 RenderCommand::model_matrix() const
+{
+    glm::mat4 matrix(1.0f);
+    matrix[0][0] = transform[0];
+    matrix[0][1] = transform[1];
+    matrix[1][0] = transform[2];
+    matrix[1][1] = transform[3];
+    matrix[3][0] = transform[4];
+    matrix[3][1] = transform[5];
+    return matrix;
+}
+
+void RenderList::clear()
+{
+    m_keys.clear();
+    m_commands.clear();
+    m_order.clear();
+    particles.clear();
+}
+
+void RenderList::push(RenderLayer layer, RenderPipeline pipeline, const SpriteFrame& frame,
+                      const glm::mat4& model_matrix)
+{
+    m_keys.push_back((uint64_t) layer << 40 | (uint64_t) pipeline << 32 | frame.texture);
+    m_commands.push_back({ frame, { model_matrix[0][0], model_matrix[0][1],
+                                    model_matrix[1][0], model_matrix[1][1],
+                                    model_matrix[3][0], model_matrix[3][1] } });
+    m_order.push_back((uint32_t) m_order.size());
+}
+
+bool RenderList::same_as(const RenderList& other) const
+{
+    // sorting only reorders m_order, so this is safe against a list the render thread is drawing
+    return m_time == other.m_time && particles.empty() && other.particles.empty() &&
+           m_keys == other.m_keys && m_commands.size() == other.m_commands.size() &&
+           memcmp(m_commands.data(), other.m_commands.data(), m_commands.size() * sizeof(RenderCommand)) == 0;
+}
+
+void RenderList::sort()
+{
+    m_scratch.resize(m_order.size());
+
+    for (int shift = 0; shift < 48; shift += 8) {
+        uint32_t counts[257] = {};
+        for (uint32_t index : m_order) counts[((m_keys[index] >> shift) & 0xff) + 1]++;
+
+        // one digit shared by every key orders nothing
+        bool shared = false;
+        for (int digit = 1; digit <= 256 && !shared; digit++) shared = counts[digit] == m_order.size();
+        if (shared) continue;
+
+        for (int digit = 1; digit <= 256; digit++) counts[digit] += counts[digit - 1];
+        for (uint32_t index : m_order) m_scratch[counts[(m_keys[index] >> shift) & 0xff]++] = index;
+        m_order.swap(m_scratch);
+    }
+}
+
+void RenderThread::start(RenderTarget target, DrawList draw)
+{
+    m_target = target;
+    m_draw = draw;
+    m_stopping = false;
+    m_thread = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop()
+{
+    if (!m_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_changed.notify_all();
+    m_thread.join();
+}
+
+RenderList& RenderThread::begin_frame()
+{
+    m_lists[m_recording].clear();
+    return m_lists[m_recording];
+}
+
+void RenderThread::submit()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this] { return m_pending < 0; });
+
+    m_pending = m_submitted = m_recording;
+
+    // with three lists there's always one neither waiting nor being drawn
+    for (int list = 0; list < LIST_COUNT; list++) {
+        if (list != m_pending && list != m_drawing) m_recording = list;
+    }
+
+    lock.unlock();
+    m_changed.notify_all();
+}
+
+bool RenderThread::submit_if_changed()
+{
+    // m_submitted is never the list being recorded, and nothing clears it until it's recorded into again
+    if (m_submitted >= 0 && m_lists[m_recording].same_as(m_lists[m_submitted])) return false;
+
+    submit();
+    return true;
+}
+
+void RenderThread::run()
+{
+    m_target.make_current(true);
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this] { return m_stopping || m_pending >= 0; });
+        if (m_pending < 0) break;   // stopping, and nothing left to draw
+
+        m_drawing = m_pending;
+        m_pending = -1;
+        lock.unlock();
+        m_changed.notify_all();
+
+        RenderList& list = m_lists[m_drawing];
+        list.sort();
+        m_draw(list);
+        m_target.present();
+
+        lock.lock();
+        m_drawing = -1;
+    }
+
+    m_target.make_current(false);
+}
+#endif
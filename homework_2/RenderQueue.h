@@ -0,0 +1,109 @@
+//
+//  RenderQueue.h
+//  exercise
+//
+//  Lets the main loop describe a frame without touching GL. The main thread
+//  records one RenderCommand per sprite into a RenderList and hands it to the
+//  RenderThread, which owns the GL context, sorts the list and draws it while
+//  the main thread simulates the next frame. Lists are triple buffered: one
+//  being recorded, one waiting, one being drawn.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "EntityStore.h"
+#include "ParticleSystem.h"
+
+struct RenderCommand {
+    SpriteFrame frame;
+    float transform[6];     // the model matrix in 2D: x axis, y axis, translation
+
+    glm::mat4 model_matrix() const;
+};
+
+class RenderList
+{
+private:
+    std::vector<uint64_t> m_keys;
+    std::vector<RenderCommand> m_commands;
+    std::vector<uint32_t> m_order;      // indices into m_commands, in draw order once sorted
+    std::vector<uint32_t> m_scratch;
+    float m_time = 0.0f;
+
+public:
+    // Drawn all at once, wherever the list's PIPELINE_PARTICLES command sorts to
+    std::vector<ParticleSystem::Instance> particles;
+
+    void clear();
+    // Seconds of animation time, for shaders that animate by themselves
+    void set_time(float time) { m_time = time; }
+    float time() const { return m_time; }
+
+    void push(RenderLayer layer, RenderPipeline pipeline, const SpriteFrame& frame, const glm::mat4& model_matrix);
+
+    // Whether drawing this would put exactly the same picture on screen as other did.
+    // Lists with particles never count, since they'd cost more to compare than to draw.
+    bool same_as(const RenderList& other) const;
+
+    // Stable LSD radix sort on (layer, pipeline, texture), a byte at a time, skipping the
+    // bytes every key shares
+    void sort();
+
+    int size() const { return (int) m_order.size(); }
+    const RenderCommand& command(int i) const { return m_commands[m_order[i]]; }
+    RenderPipeline pipeline(int i) const { return (RenderPipeline) ((m_keys[m_order[i]] >> 32) & 0xff); }
+    RenderLayer layer(int i) const { return (RenderLayer) ((m_keys[m_order[i]] >> 40) & 0xff); }
+};
+
+// Whatever the render thread draws into: a window, or an offscreen framebuffer
+struct RenderTarget {
+    void (*make_current)(bool current);     // take or release the GL context on the calling thread
+    void (*present)();                      // after each frame is drawn
+};
+
+class RenderThread
+{
+public:
+    typedef void (*DrawList)(const RenderList& list);  // called on the render thread with the GL context current
+
+private:
+    static constexpr int LIST_COUNT = 3;
+
+    RenderList m_lists[LIST_COUNT];
+    int m_recording = 0;
+    int m_pending = -1;                 // submitted, not picked up yet
+    int m_drawing = -1;
+    int m_submitted = -1;               // the latest list handed over, whether drawn yet or not
+
+    RenderTarget m_target = {};
+    DrawList m_draw = nullptr;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_stopping = false;
+
+    void run();
+
+public:
+    // The context must not be current on the calling thread any more; it moves to the new one
+    void start(RenderTarget target, DrawList draw);
+    void stop();                        // draws whatever was submitted, then joins
+
+    RenderList& begin_frame();          // cleared, for the main thread to record into
+
+    // Hands the recorded list over. Only waits if the render thread hasn't picked up the
+    // previous one yet, so the main thread never gets more than a frame ahead.
+    void submit();
+
+    // Submits the recorded list unless it's the same_as the last one, so an unchanged frame
+    // costs no drawing and no swap. Returns whether it submitted.
+    bool submit_if_changed();
+};
+
+extern RenderThread g_render_thread;
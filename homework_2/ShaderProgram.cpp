@@ -1,32 +1,181 @@
 #define GL_SILENCE_DEPRECATION
 
+#include <SDL.h>
 #include "ShaderProgram.h"
+#include <cstdio>
 
-void ShaderProgram::load(const char *vertex_shader_file, const char *fragment_shader_file) {
+GLState g_gl_state;
+
+static bool sdl_extension_supported(const char* name) { return SDL_GL_ExtensionSupported(name); }
+static void* sdl_proc_address(const char* name) { return SDL_GL_GetProcAddress(name); }
+
+GLLookup g_gl_lookup = { sdl_extension_supported, sdl_proc_address };
+
+void GLState::load()
+{
+    int major = 0, minor = 0;
+    const char* version = (const char*) glGetString(GL_VERSION);
+    if (version != nullptr) sscanf(version, "%d.%d", &major, &minor);
+
+    // glDrawArraysInstanced is core from 3.1 and glVertexAttribDivisor from 3.3; before
+    // that they're the ARB extensions' functions, under their own names
+    if (major * 10 + minor >= 33) {
+        m_draw_arrays_instanced = (DrawArraysInstancedProc) g_gl_lookup.proc_address("glDrawArraysInstanced");
+        m_vertex_attrib_divisor = (VertexAttribDivisorProc) g_gl_lookup.proc_address("glVertexAttribDivisor");
+    }
+    else if (g_gl_lookup.extension_supported("GL_ARB_instanced_arrays")) {
+        // ARB_instanced_arrays brings its own glDrawArraysInstancedARB, as does ARB_draw_instanced
+        m_draw_arrays_instanced = (DrawArraysInstancedProc) g_gl_lookup.proc_address("glDrawArraysInstancedARB");
+        m_vertex_attrib_divisor = (VertexAttribDivisorProc) g_gl_lookup.proc_address("glVertexAttribDivisorARB");
+    }
+}
+
+void GLState::use_program(GLuint program)
+{
+    if (program == m_program) { elided++; return; }
+
+    glUseProgram(program);
+    m_program = program;
+    issued++;
+}
+
+void GLState::bind_texture(GLuint texture)
+{
+    if (texture == m_texture) { elided++; return; }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    m_texture = texture;
+    issued++;
+}
+
+void GLState::bind_array_buffer(GLuint buffer)
+{
+    if (buffer == m_array_buffer) { elided++; return; }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    m_array_buffer = buffer;
+    issued++;
+}
+
+void GLState::use_attributes(uint32_t per_vertex, uint32_t per_instance)
+{
+    uint32_t enabled = per_vertex | per_instance;
+    uint32_t was_enabled = m_per_vertex | m_per_instance;
+
+    for (GLuint index = 0; index < 32; index++) {
+        uint32_t bit = 1u << index;
+        if (!((enabled | was_enabled) & bit)) continue;
+
+        if ((enabled & bit) != (was_enabled & bit)) {
+            if (enabled & bit) glEnableVertexAttribArray(index);
+            else glDisableVertexAttribArray(index);
+            issued++;
+        }
+        else elided++;
+
+        // a divisor left on a disabled array would still apply once something re-enables it
+        if ((per_instance & bit) != (m_per_instance & bit)) {
+            m_vertex_attrib_divisor(index, (per_instance & bit) ? 1 : 0);
+            issued++;
+        }
+    }
+
+    m_per_vertex = per_vertex;
+    m_per_instance = per_instance;
+}
+
+std::string ShaderProgram::binary_cache_directory;
+
+typedef void (APIENTRY *MaxShaderCompilerThreadsProc)(GLuint count);
+
+// Lets the driver compile on as many threads as it likes, the first time anything loads
+static void allow_parallel_compile()
+{
+    static bool asked = false;
+    if (asked) return;
+    asked = true;
+
+    if (!g_gl_lookup.extension_supported("GL_KHR_parallel_shader_compile")) return;
+    auto max_shader_compiler_threads =
+        (MaxShaderCompilerThreadsProc) g_gl_lookup.proc_address("glMaxShaderCompilerThreadsKHR");
+    if (max_shader_compiler_threads != nullptr) max_shader_compiler_threads(0xFFFFFFFF);
+}
+
+void ShaderProgram::begin_load(const char *vertex_shader_file, const char *fragment_shader_file,
+                               const std::string &defines) {
     
+    allow_parallel_compile();
+
+    m_vertex_source = defines + read_shader_file(vertex_shader_file);
+    m_fragment_source = defines + read_shader_file(fragment_shader_file);
+    m_cache_path = binary_cache_path(m_vertex_source, m_fragment_source);
+
+    m_program_id = glCreateProgram();
+    m_vertex_shader = m_fragment_shader = 0;
+
+    m_from_binary = !m_cache_path.empty() && start_binary(m_cache_path);
+    if (!m_from_binary) link_from_source();
+    m_pending = true;
+}
+
+void ShaderProgram::link_from_source()
+{
     // create the vertex shader
-    m_vertex_shader = load_shader_from_file(vertex_shader_file, GL_VERTEX_SHADER);
+    m_vertex_shader = load_shader_from_string(m_vertex_source, GL_VERTEX_SHADER);
     // create the fragment shader
-    m_fragment_shader = load_shader_from_file(fragment_shader_file, GL_FRAGMENT_SHADER);
+    m_fragment_shader = load_shader_from_string(m_fragment_source, GL_FRAGMENT_SHADER);
     
     // Create the final shader program from our vertex and fragment shaders
-    m_program_id = glCreateProgram();
     glAttachShader(m_program_id, m_vertex_shader);
     glAttachShader(m_program_id, m_fragment_shader);
+    if (!m_cache_path.empty()) glProgramParameteri(m_program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(m_program_id);
-    
+}
+
+// Everything that waits on the driver, done once, just before the program is first needed
+void ShaderProgram::resolve()
+{
+    if (!m_pending) return;
+    m_pending = false;
+
     GLint link_success;
     glGetProgramiv(m_program_id, GL_LINK_STATUS, &link_success);
-    
+
+    // a binary the driver rejects leaves the program unlinked, to be built from source as usual
+    if (m_from_binary && link_success == GL_FALSE) {
+        m_from_binary = false;
+        link_from_source();
+        glGetProgramiv(m_program_id, GL_LINK_STATUS, &link_success);
+    }
+
+    if (!m_from_binary) {
+        // If a shader did not compile, print the error to stdout
+        for (GLuint shader : { m_vertex_shader, m_fragment_shader }) {
+            GLint compile_success;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_success);
+            if (compile_success == GL_FALSE)
+            {
+                GLchar messages[512];
+                glGetShaderInfoLog(shader, sizeof(messages), 0, &messages[0]);
+                std::cout << messages << std::endl;
+            }
+        }
+    }
+
     if(link_success == GL_FALSE)
     {
         printf("Error linking shader program!\n");
     }
+    else if (!m_from_binary && !m_cache_path.empty()) save_binary(m_cache_path);
+
+    m_vertex_source.clear();
+    m_fragment_source.clear();
     
     m_model_matrix_uniform      = glGetUniformLocation(m_program_id, "modelMatrix");
     m_projection_matrix_uniform = glGetUniformLocation(m_program_id, "projectionMatrix");
     m_view_matrix_uniform       = glGetUniformLocation(m_program_id, "viewMatrix");
     m_colour_uniform            = glGetUniformLocation(m_program_id, "color");
+    m_time_uniform              = glGetUniformLocation(m_program_id, "time");
     
     m_position_attribute  = glGetAttribLocation(m_program_id, "position");
     m_tex_coord_attribute = glGetAttribLocation(m_program_id, "texCoord");
@@ -42,7 +191,7 @@ void ShaderProgram::cleanup()
     glDeleteShader(m_fragment_shader);
 }
 
-GLuint ShaderProgram::load_shader_from_file(const std::string &shaderFile, GLenum type)
+std::string ShaderProgram::read_shader_file(const std::string &shaderFile)
 {
     //Open a file stream with the file name
     std::ifstream infile(shaderFile);
@@ -54,9 +203,70 @@ GLuint ShaderProgram::load_shader_from_file(const std::string &shaderFile, GLenu
     //Create a string buffer and stream the file to it
     std::stringstream buffer;
     buffer << infile.rdbuf();
-    
-    // Load the shader from the contents of the file
-    return load_shader_from_string(buffer.str(), type);
+    return buffer.str();
+}
+
+// FNV-1a, continued across several strings
+static uint64_t hash_string(uint64_t hash, const char* string)
+{
+    for (; string != nullptr && *string != '\0'; string++) {
+        hash ^= (unsigned char) *string;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string ShaderProgram::binary_cache_path(const std::string &vertex_source, const std::string &fragment_source) const
+{
+    if (binary_cache_directory.empty()) return "";
+
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    if (format_count <= 0) return "";   // no program binaries on this driver
+
+    // a binary is only good for the driver that made it
+    uint64_t hash = 14695981039346656037ull;
+    hash = hash_string(hash, vertex_source.c_str());
+    hash = hash_string(hash, "\n--\n");
+    hash = hash_string(hash, fragment_source.c_str());
+    hash = hash_string(hash, (const char*) glGetString(GL_VENDOR));
+    hash = hash_string(hash, (const char*) glGetString(GL_RENDERER));
+    hash = hash_string(hash, (const char*) glGetString(GL_VERSION));
+
+    char name[32];
+    snprintf(name, sizeof(name), "program_%016llx.bin", (unsigned long long) hash);
+    return binary_cache_directory + name;
+}
+
+// Hands a saved binary to the driver; whether it was accepted is asked in resolve()
+bool ShaderProgram::start_binary(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (file.fail()) return false;
+
+    GLenum format;
+    file.read((char*) &format, sizeof(format));
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (file.bad() || binary.empty()) return false;
+
+    glProgramBinary(m_program_id, format, binary.data(), (GLsizei) binary.size());
+    return true;
+}
+
+void ShaderProgram::save_binary(const std::string &path) const
+{
+    GLint length = 0;
+    glGetProgramiv(m_program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(m_program_id, length, nullptr, &format, binary.data());
+
+    // a failed write just means compiling again next launch
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char*) &format, sizeof(format));
+    file.write(binary.data(), binary.size());
 }
 
 GLuint ShaderProgram::load_shader_from_string(const std::string &shaderContents, GLenum type)
@@ -72,42 +282,62 @@ GLuint ShaderProgram::load_shader_from_string(const std::string &shaderContents,
     glShaderSource(shaderID, 1, &shader_string, &shader_string_length);
     glCompileShader(shaderID);
     
-    // Check if the shader compiled properly
-    GLint compile_success;
-    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &compile_success);
-    
-    // If the shader did not compile, print the error to stdout
-    if (compile_success == GL_FALSE)
-    {
-        GLchar messages[512];
-        glGetShaderInfoLog(shaderID, sizeof(messages), 0, &messages[0]);
-        std::cout << messages << std::endl;
-    }
-    
     // return the shader id
     return shaderID;
 }
 
 void ShaderProgram::set_colour(float red, float green, float blue, float alpha)
 {
-    glUseProgram(m_program_id);
+    glm::vec4 colour(red, green, blue, alpha);
+    if (m_colour_set && colour == m_colour) { g_gl_state.elided++; return; }
+
+    use();
     glUniform4f(m_colour_uniform, red, green, blue, alpha);
+    m_colour = colour;
+    m_colour_set = true;
+    g_gl_state.issued++;
+}
+
+void ShaderProgram::set_time(float time)
+{
+    if (m_time_set && time == m_time) { g_gl_state.elided++; return; }
+
+    use();
+    glUniform1f(m_time_uniform, time);
+    m_time = time;
+    m_time_set = true;
+    g_gl_state.issued++;
 }
 
 void ShaderProgram::set_view_matrix(const glm::mat4 &matrix)
 {
-    glUseProgram(m_program_id);
+    if (m_view_matrix_set && matrix == m_view_matrix) { g_gl_state.elided++; return; }
+
+    use();
     glUniformMatrix4fv(m_view_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    m_view_matrix = matrix;
+    m_view_matrix_set = true;
+    g_gl_state.issued++;
 }
 
 void ShaderProgram::set_model_matrix(const glm::mat4 &matrix)
 {
-    glUseProgram(m_program_id);
+    if (m_model_matrix_set && matrix == m_model_matrix) { g_gl_state.elided++; return; }
+
+    use();
     glUniformMatrix4fv(m_model_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    m_model_matrix = matrix;
+    m_model_matrix_set = true;
+    g_gl_state.issued++;
 }
 
 void ShaderProgram::set_projection_matrix(const glm::mat4 &matrix)
 {
-    glUseProgram(m_program_id);
+    if (m_projection_matrix_set && matrix == m_projection_matrix) { g_gl_state.elided++; return; }
+
+    use();
     glUniformMatrix4fv(m_projection_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    m_projection_matrix = matrix;
+    m_projection_matrix_set = true;
+    g_gl_state.issued++;
 }
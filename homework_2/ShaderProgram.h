@@ -9,15 +9,84 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstdint>
+#include <vector>
 #include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+
+// Remembers what's bound in the GL context so binding the same thing again costs
+// nothing. Only holds while every bind, enable and divisor change goes through here.
+// Also holds the instancing entry points, which older drivers only have as extensions.
+class GLState
+{
+private:
+    GLuint m_program = 0;
+    GLuint m_texture = 0;
+    GLuint m_array_buffer = 0;
+    uint32_t m_per_vertex = 0;      // enabled attribute arrays, one bit per index
+    uint32_t m_per_instance = 0;    // the ones among them with a divisor of 1
+
+    typedef void (APIENTRY *DrawArraysInstancedProc)(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+    typedef void (APIENTRY *VertexAttribDivisorProc)(GLuint index, GLuint divisor);
+    DrawArraysInstancedProc m_draw_arrays_instanced = nullptr;
+    VertexAttribDivisorProc m_vertex_attrib_divisor = nullptr;
+
+public:
+    int issued = 0;     // state changes and uniform uploads sent to GL since reset_counters()
+    int elided = 0;     // ones skipped because nothing would have changed
+
+    void use_program(GLuint program);
+    void bind_texture(GLuint texture);
+    void bind_array_buffer(GLuint buffer);
+    void forget_array_buffer(GLuint buffer) { if (m_array_buffer == buffer) m_array_buffer = 0; }  // just deleted
+
+    // Enables exactly these attribute arrays and disables the rest; per_instance ones
+    // advance once per instance instead of once per vertex
+    void use_attributes(uint32_t per_vertex, uint32_t per_instance = 0);
+
+    void reset_counters() { issued = elided = 0; }
+
+    // Once there's a context, before anything asks instancing(). Without instancing,
+    // use_attributes() must only ever be given per_vertex arrays.
+    void load();
+
+    bool instancing() const { return m_draw_arrays_instanced != nullptr && m_vertex_attrib_divisor != nullptr; }
+    void draw_arrays_instanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+    {
+        m_draw_arrays_instanced(mode, first, count, instances);
+    }
+
+    // The bit use_attributes() takes for an attribute location; none for one the program lacks
+    static uint32_t bit(GLint attribute) { return attribute >= 0 && attribute < 32 ? 1u << attribute : 0; }
+};
+
+extern GLState g_gl_state;
+
+// Extension checks and entry points for the current context. SDL's only answer for a
+// window SDL made, so whatever makes a context some other way (e.g. the offscreen one,
+// through EGL) swaps in its own.
+struct GLLookup {
+    bool (*extension_supported)(const char* name);
+    void* (*proc_address)(const char* name);
+};
+
+extern GLLookup g_gl_lookup;
 
 class ShaderProgram
 {
 private:
     void cleanup();
     
+    // Starts compiling; whether it worked is only asked for in resolve()
     GLuint load_shader_from_string(const std::string &shader_contents, GLenum shader_type);
-    GLuint load_shader_from_file(const std::string &shader_file, GLenum shader_type);
+    static std::string read_shader_file(const std::string &shader_file);
+    void link_from_source();
+    void resolve();
+
+    // Linked programs saved by the driver, keyed by a hash of both sources and the driver
+    std::string binary_cache_path(const std::string &vertex_source, const std::string &fragment_source) const;
+    bool start_binary(const std::string &path);
+    void save_binary(const std::string &path) const;
 
     GLuint m_program_id;
 
@@ -25,25 +94,47 @@ private:
     GLuint m_model_matrix_uniform;
     GLuint m_view_matrix_uniform;
     GLuint m_colour_uniform;
+    GLuint m_time_uniform;
 
     GLuint m_position_attribute;
     GLuint m_tex_coord_attribute;
 
     GLuint m_vertex_shader;
     GLuint m_fragment_shader;
+
+    // kept between begin_load() and resolve(), in case the driver turns the cached binary down
+    bool m_pending = false;
+    bool m_from_binary = false;
+    std::string m_vertex_source, m_fragment_source, m_cache_path;
+
+    // last values uploaded, so setting the same one again is skipped
+    glm::mat4 m_model_matrix, m_projection_matrix, m_view_matrix;
+    glm::vec4 m_colour;
+    float m_time;
+    bool m_model_matrix_set = false, m_projection_matrix_set = false, m_view_matrix_set = false,
+         m_colour_set = false, m_time_set = false;
     
 public:
+    // Where linked program binaries are kept between launches; empty to always compile
+    static std::string binary_cache_directory;
 
-    void load(const char *vertex_shader_file, const char *fragment_shader_file);
+    // Hands both shaders to the driver and returns without waiting for them. Where it
+    // has KHR_parallel_shader_compile they build in the background; either way, errors,
+    // uniforms and attributes are only looked at the first time the program is used.
+    // defines (e.g. "#define TAPS 3\n") go at the top of both shaders.
+    void begin_load(const char *vertex_shader_file, const char *fragment_shader_file, const std::string &defines = "");
+    void load(const char *vertex_shader_file, const char *fragment_shader_file) { begin_load(vertex_shader_file, fragment_shader_file); resolve(); }
+    void use() { resolve(); g_gl_state.use_program(m_program_id); }
 
     void set_model_matrix(const glm::mat4 &matrix);
     void set_projection_matrix(const glm::mat4 &matrix);
     void set_view_matrix(const glm::mat4 &matrix);
     void set_colour(float red, float green, float blue, float alpha);
+    void set_time(float time);      // for shaders with a "time" uniform
     
-    GLuint const get_program_id()               const { return m_program_id;          };
-    GLuint const get_position_attribute()       const { return m_position_attribute;  };
-    GLuint const get_tex_coordinate_attribute() const { return m_tex_coord_attribute; };
+    GLuint const get_program_id()               { resolve(); return m_program_id;          };
+    GLuint const get_position_attribute()       { resolve(); return m_position_attribute;  };
+    GLuint const get_tex_coordinate_attribute() { resolve(); return m_tex_coord_attribute; };
     
     void set_program_id(GLuint program_id)                         { m_program_id = program_id;                   };
 };
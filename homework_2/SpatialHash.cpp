@@ -0,0 +1,98 @@
+//
+//  SpatialHash.cpp
+//  exercise
+//
+
+#include "SpatialHash.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(float cell_size, int bucket_count)
+    : m_cell_size(cell_size), m_min_buckets(bucket_count), m_bucket_mask(0)
+{
+    m_bucket_starts.resize(2);
+}
+
+uint32_t SpatialHash::bucket(int cell_x, int cell_y) const
+{
+    uint32_t hash = (uint32_t) cell_x * 73856093u ^ (uint32_t) cell_y * 19349663u;
+    hash ^= hash >> 16;         // fold the high bits down, the mask only keeps the low ones
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return hash & m_bucket_mask;
+}
+
+void SpatialHash::cell_range(const glm::vec3& position, const glm::vec3& scale,
+                             int& min_x, int& min_y, int& max_x, int& max_y) const
+{
+    min_x = (int) floor((position.x - scale.x / 2.0f) / m_cell_size);
+    min_y = (int) floor((position.y - scale.y / 2.0f) / m_cell_size);
+    max_x = (int) floor((position.x + scale.x / 2.0f) / m_cell_size);
+    max_y = (int) floor((position.y + scale.y / 2.0f) / m_cell_size);
+}
+
+void SpatialHash::clear()
+{
+    m_entries.clear();
+    m_ids.clear();
+}
+
+void SpatialHash::insert(int id, const glm::vec3& position, const glm::vec3& scale)
+{
+    int min_x, min_y, max_x, max_y;
+    cell_range(position, scale, min_x, min_y, max_x, max_y);
+
+    for (int y = min_y; y <= max_y; y++) {
+        for (int x = min_x; x <= max_x; x++) {
+            m_entries.push_back({ x, y, id });
+        }
+    }
+
+    m_id_limit = std::max(m_id_limit, id + 1);
+}
+
+// Counting sort of the entries by bucket
+void SpatialHash::build()
+{
+    uint32_t buckets = 1;
+    while (buckets < (uint32_t) m_min_buckets || buckets < 2 * m_entries.size()) buckets <<= 1;
+
+    m_bucket_mask = buckets - 1;
+    m_bucket_starts.assign(buckets + 1, 0);
+
+    for (const Entry& entry : m_entries) m_bucket_starts[bucket(entry.cell_x, entry.cell_y) + 1]++;
+    for (size_t i = 1; i < m_bucket_starts.size(); i++) m_bucket_starts[i] += m_bucket_starts[i - 1];
+
+    m_ids.resize(m_entries.size());
+    m_cursors.assign(m_bucket_starts.begin(), m_bucket_starts.end() - 1);
+
+    for (const Entry& entry : m_entries) m_ids[m_cursors[bucket(entry.cell_x, entry.cell_y)]++] = entry.id;
+}
+
+void SpatialHash::query(const glm::vec3& position, const glm::vec3& scale, std::vector<int>& candidates,
+                        Visited& visited) const
+{
+    if ((int) visited.stamps.size() < m_id_limit) visited.stamps.resize(m_id_limit, 0);
+
+    if (++visited.query == 0) {     // stamp counter wrapped, forget every old stamp
+        std::fill(visited.stamps.begin(), visited.stamps.end(), 0);
+        visited.query = 1;
+    }
+
+    int min_x, min_y, max_x, max_y;
+    cell_range(position, scale, min_x, min_y, max_x, max_y);
+
+    for (int y = min_y; y <= max_y; y++) {
+        for (int x = min_x; x <= max_x; x++) {
+            uint32_t b = bucket(x, y);
+
+            for (int i = m_bucket_starts[b]; i < m_bucket_starts[b + 1]; i++) {
+                int id = m_ids[i];
+                if (visited.stamps[id] == visited.query) continue;
+
+                visited.stamps[id] = visited.query;
+                candidates.push_back(id);
+            }
+        }
+    }
+}
@@ -0,0 +1,71 @@
+//
+//  SpatialHash.h
+//  exercise
+//
+//  Uniform-grid broadphase. Boxes are hashed into every cell they overlap; a
+//  query returns each id sharing a cell with the query box once, for the
+//  narrowphase (EntityStore::check_collision) to confirm. Rebuilt from scratch
+//  every step with a counting sort, so there are no per-cell allocations; the
+//  bucket table grows with the number of entries to keep buckets short.
+//  Queries only read the grid, so threads can share one as long as each
+//  brings its own Visited.
+//
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "glm/mat4x4.hpp"
+
+class SpatialHash
+{
+private:
+    struct Entry { int cell_x, cell_y, id; };
+
+    float m_cell_size;
+    int m_min_buckets;
+    uint32_t m_bucket_mask;
+
+    std::vector<Entry> m_entries;           // every cell each box touches
+    std::vector<int> m_bucket_starts;       // prefix sums into m_ids after build()
+    std::vector<int> m_ids;                 // ids grouped by bucket
+    std::vector<int> m_cursors;             // scratch for build()
+
+    int m_id_limit = 0;                     // one past the largest id inserted
+
+public:
+    // Last query each id was returned by, for dedup
+    struct Visited {
+        std::vector<uint32_t> stamps;
+        uint32_t query = 0;
+    };
+
+private:
+    mutable Visited m_visited;              // for the single-threaded query()
+
+    uint32_t bucket(int cell_x, int cell_y) const;
+    void cell_range(const glm::vec3& position, const glm::vec3& scale,
+                    int& min_x, int& min_y, int& max_x, int& max_y) const;
+
+public:
+    static constexpr float DEFAULT_CELL_SIZE = 1.0f;   // about one ball across
+    static constexpr int DEFAULT_BUCKETS = 4096;       // rounded up to a power of two
+
+    SpatialHash(float cell_size = DEFAULT_CELL_SIZE, int bucket_count = DEFAULT_BUCKETS);
+
+    void clear();
+    void set_cell_size(float cell_size) { m_cell_size = cell_size; }     // only between clear() and insert()
+    void insert(int id, const glm::vec3& position, const glm::vec3& scale);
+    void build();
+
+    // Appends every id whose cells overlap the box (including, if inserted, the querier)
+    void query(const glm::vec3& position, const glm::vec3& scale, std::vector<int>& candidates) const
+    {
+        query(position, scale, candidates, m_visited);
+    }
+    void query(const glm::vec3& position, const glm::vec3& scale, std::vector<int>& candidates,
+               Visited& visited) const;
+
+    int entry_count() const { return (int) m_entries.size(); }
+    const std::vector<int>& ids() const { return m_ids; }   // grouped by bucket after build(), so nearby ids sit together
+};
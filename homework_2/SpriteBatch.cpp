@@ -0,0 +1,71 @@
+//
+//  SpriteBatch.cpp
+//  exercise
+//
+
+#ifndef HEADLESS
+#define GL_SILENCE_DEPRECATION
+
+#include "SpriteBatch.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include <cstddef>
+
+void SpriteBatch::begin(ShaderProgram* program)
+{
+    m_program = program;
+    m_texture = 0;
+    m_draw_calls = 0;
+    m_vertices.clear();
+
+    m_program->set_model_matrix(glm::mat4(1.0f));   // vertices arrive already in world space
+}
+
+void SpriteBatch::draw(GLuint texture, const glm::mat4& model_matrix, float u, float v, float width, float height)
+{
+    if (texture != m_texture) {
+        flush();
+        m_texture = texture;
+    }
+
+    // same two triangles, in the same order, as drawing one sprite on its own
+    static const float CORNERS[6][2] = {
+        { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f },
+        { -0.5f, -0.5f }, { 0.5f,  0.5f }, { -0.5f, 0.5f }
+    };
+    const float tex_coords[6][2] = {
+        { u, v + height }, { u + width, v + height }, { u + width, v },
+        { u, v + height }, { u + width, v },          { u, v }
+    };
+
+    for (int i = 0; i < 6; i++) {
+        float x = CORNERS[i][0], y = CORNERS[i][1];
+        m_vertices.push_back({ model_matrix[0][0] * x + model_matrix[1][0] * y + model_matrix[3][0],
+                               model_matrix[0][1] * x + model_matrix[1][1] * y + model_matrix[3][1],
+                               tex_coords[i][0], tex_coords[i][1] });
+    }
+}
+
+void SpriteBatch::flush()
+{
+    if (m_vertices.empty()) return;
+
+    GLuint position = m_program->get_position_attribute();
+    GLuint tex_coord = m_program->get_tex_coordinate_attribute();
+
+    m_program->use();     // something else may have drawn since begin()
+    g_gl_state.bind_texture(m_texture);
+
+    size_t offset = g_stream_buffer.upload(m_vertices.data(), m_vertices.size() * sizeof(Vertex));
+    glVertexAttribPointer(position, 2, GL_FLOAT, false, sizeof(Vertex),
+                          (const void*) (offset + offsetof(Vertex, x)));
+    glVertexAttribPointer(tex_coord, 2, GL_FLOAT, false, sizeof(Vertex),
+                          (const void*) (offset + offsetof(Vertex, u)));
+    g_gl_state.use_attributes(GLState::bit(position) | GLState::bit(tex_coord));
+
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei) m_vertices.size());
+    m_draw_calls++;
+
+    m_vertices.clear();
+}
+#endif
@@ -0,0 +1,45 @@
+//
+//  SpriteBatch.h
+//  exercise
+//
+//  Collects textured quads into one vertex stream and draws them with a single
+//  glDrawArrays per run of quads sharing a texture, sourced from g_stream_buffer. Corners are transformed on
+//  the CPU, so the shader's model matrix stays at identity for the whole batch.
+//  Quads are drawn in the order they're added, so blending still layers
+//  correctly; keeping things with the same texture together keeps runs long.
+//
+
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <vector>
+#include "glm/mat4x4.hpp"
+
+class ShaderProgram;
+
+class SpriteBatch
+{
+private:
+    struct Vertex { float x, y, u, v; };
+
+    std::vector<Vertex> m_vertices;
+    ShaderProgram* m_program = nullptr;
+    GLuint m_texture = 0;
+    int m_draw_calls = 0;
+
+public:
+    void begin(ShaderProgram* program);
+
+    // A unit quad centred on the origin, placed by model_matrix, showing the (u, v, width,
+    // height) part of the texture
+    void draw(GLuint texture, const glm::mat4& model_matrix, float u, float v, float width, float height);
+
+    void flush();
+    void end() { flush(); }
+
+    int draw_calls() const { return m_draw_calls; }     // since begin()
+};
@@ -0,0 +1,99 @@
+//
+//  SpriteInstancer.cpp
+//  exercise
+//
+
+#ifndef HEADLESS
+#define GL_SILENCE_DEPRECATION
+
+#include "SpriteInstancer.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include <cstddef>
+#include <cmath>
+
+void SpriteInstancer::load(ShaderProgram* program)
+{
+    m_program = program;
+
+    // same two triangles, in the same order, as drawing one sprite on its own
+    static const float QUAD[] = {
+        -0.5f, -0.5f, 0.5f, -0.5f,  0.5f, 0.5f,
+        -0.5f, -0.5f, 0.5f,  0.5f, -0.5f, 0.5f
+    };
+
+    glGenBuffers(1, &m_quad_buffer);
+    g_gl_state.bind_array_buffer(m_quad_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+
+    GLuint program_id = m_program->get_program_id();
+    m_instance_position_attribute = glGetAttribLocation(program_id, "instancePosition");
+    m_instance_scale_attribute    = glGetAttribLocation(program_id, "instanceScale");
+    m_instance_rotation_attribute = glGetAttribLocation(program_id, "instanceRotation");
+    m_instance_frame_attribute    = glGetAttribLocation(program_id, "instanceFrame");
+}
+
+void SpriteInstancer::begin()
+{
+    m_texture = 0;
+    m_draw_calls = 0;
+    m_instances.clear();
+}
+
+void SpriteInstancer::draw(GLuint texture, float x, float y, float scale_x, float scale_y, float rotation,
+                           float u, float v, float width, float height)
+{
+    if (texture != m_texture) {
+        flush();
+        m_texture = texture;
+    }
+
+    m_instances.push_back({ x, y, scale_x, scale_y, rotation, u, v, width, height });
+}
+
+void SpriteInstancer::draw(GLuint texture, const glm::mat4& model_matrix, float u, float v, float width, float height)
+{
+    // x axis = rotation * (scale_x, 0) and y axis = rotation * (0, scale_y); taking scale_x as
+    // positive leaves any mirroring in the sign of scale_y, which draws the same
+    float x_axis_x = model_matrix[0][0], x_axis_y = model_matrix[0][1];
+    float scale_x = sqrtf(x_axis_x * x_axis_x + x_axis_y * x_axis_y);
+    float determinant = x_axis_x * model_matrix[1][1] - x_axis_y * model_matrix[1][0];
+
+    draw(texture, model_matrix[3][0], model_matrix[3][1], scale_x, scale_x > 0.0f ? determinant / scale_x : 0.0f,
+         atan2f(x_axis_y, x_axis_x), u, v, width, height);
+}
+
+void SpriteInstancer::flush()
+{
+    if (m_instances.empty()) return;
+
+    GLuint position = m_program->get_position_attribute();
+    const struct { GLint attribute; int size; size_t offset; } instance_attributes[] = {
+        { m_instance_position_attribute, 2, offsetof(Instance, x) },
+        { m_instance_scale_attribute,    2, offsetof(Instance, scale_x) },
+        { m_instance_rotation_attribute, 1, offsetof(Instance, rotation) },
+        { m_instance_frame_attribute,    4, offsetof(Instance, u) },
+    };
+
+    m_program->use();
+    g_gl_state.bind_texture(m_texture);
+
+    g_gl_state.bind_array_buffer(m_quad_buffer);
+    glVertexAttribPointer(position, 2, GL_FLOAT, false, 0, nullptr);
+
+    size_t base = g_stream_buffer.upload(m_instances.data(), m_instances.size() * sizeof(Instance));
+
+    uint32_t per_instance = 0;
+    for (const auto& instance : instance_attributes) {
+        glVertexAttribPointer(instance.attribute, instance.size, GL_FLOAT, false, sizeof(Instance),
+                              (const void*) (base + instance.offset));
+        per_instance |= GLState::bit(instance.attribute);
+    }
+    g_gl_state.use_attributes(GLState::bit(position), per_instance);
+
+    g_gl_state.draw_arrays_instanced(GL_TRIANGLES, 0, 6, (GLsizei) m_instances.size());
+    m_draw_calls++;
+
+    m_instances.clear();
+}
+#endif
@@ -0,0 +1,64 @@
+//
+//  SpriteInstancer.h
+//  exercise
+//
+//  Draws many copies of one textured unit quad with glDrawArraysInstanced.
+//  The quad lives in a static buffer; each sprite adds only its position,
+//  scale, rotation and frame to a per-instance array, which goes into
+//  g_stream_buffer once per flush. The model matrix is built in the vertex shader, so this needs
+//  its own program (shaders/vertex_instanced.glsl) rather than the one
+//  SpriteBatch draws with.
+//
+
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <vector>
+#include "glm/mat4x4.hpp"
+
+class ShaderProgram;
+
+class SpriteInstancer
+{
+private:
+    struct Instance {
+        float x, y;
+        float scale_x, scale_y;
+        float rotation;
+        float u, v, width, height;
+    };
+
+    std::vector<Instance> m_instances;
+    ShaderProgram* m_program = nullptr;
+    GLuint m_texture = 0;
+    GLuint m_quad_buffer = 0;
+    int m_draw_calls = 0;
+
+    GLint m_instance_position_attribute;
+    GLint m_instance_scale_attribute;
+    GLint m_instance_rotation_attribute;
+    GLint m_instance_frame_attribute;
+
+public:
+    // Once there's a GL context; program should be built from shaders/vertex_instanced.glsl
+    void load(ShaderProgram* program);
+
+    void begin();
+
+    // A unit quad centred on (x, y), scaled then rotated about its centre, showing the
+    // (u, v, width, height) part of the texture
+    void draw(GLuint texture, float x, float y, float scale_x, float scale_y, float rotation,
+              float u, float v, float width, float height);
+
+    // The same, taking apart a 2D model matrix (translate * rotate * scale, as interpolate() builds)
+    void draw(GLuint texture, const glm::mat4& model_matrix, float u, float v, float width, float height);
+
+    void flush();
+    void end() { flush(); }
+
+    int draw_calls() const { return m_draw_calls; }     // since begin()
+};
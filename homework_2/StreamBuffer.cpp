@@ -0,0 +1,110 @@
+//
+//  StreamBuffer.cpp
+//  exercise
+//
+
+#ifndef HEADLESS
+#define GL_SILENCE_DEPRECATION
+
+#include <cstring>
+#include "StreamBuffer.h"
+#include "ShaderProgram.h"
+
+StreamBuffer g_stream_buffer;
+
+// Looked up at run time: not every platform's GL exports it
+static PFNGLBUFFERSTORAGEPROC buffer_storage = nullptr;
+
+void StreamBuffer::load(size_t size)
+{
+    if (g_gl_lookup.extension_supported("GL_ARB_buffer_storage")) {
+        buffer_storage = (PFNGLBUFFERSTORAGEPROC) g_gl_lookup.proc_address("glBufferStorage");
+    }
+    m_persistent = buffer_storage != nullptr;
+
+    allocate(m_persistent ? size / FRAMES_IN_FLIGHT : size);
+}
+
+void StreamBuffer::allocate(size_t size)
+{
+    // whatever is still drawing from the old buffer keeps it alive until it's done
+    if (m_buffer != 0) {
+        g_gl_state.bind_array_buffer(m_buffer);
+        if (m_persistent) glUnmapBuffer(GL_ARRAY_BUFFER);
+        glDeleteBuffers(1, &m_buffer);
+        g_gl_state.forget_array_buffer(m_buffer);
+    }
+    for (GLsync& fence : m_fences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    m_size = size;
+    glGenBuffers(1, &m_buffer);
+    g_gl_state.bind_array_buffer(m_buffer);
+
+    if (m_persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        buffer_storage(GL_ARRAY_BUFFER, m_size * FRAMES_IN_FLIGHT, nullptr, flags);
+        m_mapped = (unsigned char*) glMapBufferRange(GL_ARRAY_BUFFER, 0, m_size * FRAMES_IN_FLIGHT, flags);
+    }
+    else {
+        glBufferData(GL_ARRAY_BUFFER, m_size, nullptr, GL_STREAM_DRAW);
+    }
+
+    m_head = region_start();
+    m_waited = true;    // a new buffer has nothing in flight
+}
+
+size_t StreamBuffer::upload(const void* data, size_t bytes)
+{
+    size_t region_end = region_start() + m_size;
+
+    if (m_persistent) {
+        if (!m_waited && m_fences[m_frame]) {
+            // only blocks if the GPU is more than FRAMES_IN_FLIGHT - 1 frames behind
+            if (glClientWaitSync(m_fences[m_frame], 0, 0) == GL_TIMEOUT_EXPIRED) {
+                waits++;
+                glClientWaitSync(m_fences[m_frame], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            }
+            glDeleteSync(m_fences[m_frame]);
+            m_fences[m_frame] = nullptr;
+        }
+        m_waited = true;
+
+        if (m_head + bytes > region_end) {
+            size_t size = m_size;
+            while (size < bytes) size *= 2;
+            allocate(size * 2);
+        }
+    }
+    else if (m_head + bytes > region_end) {
+        // orphan: same buffer name, fresh storage, so nothing written here can be in flight
+        if (bytes > m_size) m_size = bytes * 2;
+        g_gl_state.bind_array_buffer(m_buffer);
+        glBufferData(GL_ARRAY_BUFFER, m_size, nullptr, GL_STREAM_DRAW);
+        m_head = 0;
+    }
+
+    size_t offset = m_head;
+    m_head = (m_head + bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    g_gl_state.bind_array_buffer(m_buffer);
+    if (m_persistent) std::memcpy(m_mapped + offset, data, bytes);
+    else glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+
+    return offset;
+}
+
+void StreamBuffer::end_frame()
+{
+    if (!m_persistent) return;      // the head just carries on into the next frame
+
+    if (m_fences[m_frame]) glDeleteSync(m_fences[m_frame]);
+    m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_frame = (m_frame + 1) % FRAMES_IN_FLIGHT;
+    m_head = region_start();
+    m_waited = false;
+}
+#endif
@@ -0,0 +1,60 @@
+//
+//  StreamBuffer.h
+//  exercise
+//
+//  One vertex buffer that per-frame geometry (sprite batches, instance data) is
+//  appended to, so nothing is drawn from client memory. Where the driver has
+//  ARB_buffer_storage the buffer is mapped once, persistently, and split into
+//  one region per frame in flight; a fence at the end of each frame guards its
+//  region until the GPU has read it. Elsewhere it falls back to orphaning: when
+//  the buffer fills up it's reallocated and the driver keeps the old storage
+//  alive for draws still using it. Either way the CPU never waits on a draw
+//  from the current or previous frame.
+//
+
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <cstddef>
+
+class StreamBuffer
+{
+private:
+    static constexpr int FRAMES_IN_FLIGHT = 3;
+    static constexpr size_t ALIGNMENT = 16;
+
+    GLuint m_buffer = 0;
+    size_t m_size = 0;              // bytes; a whole region each when persistent
+    size_t m_head = 0;              // next free byte
+    int m_frame = 0;                // region being written, when persistent
+
+    bool m_persistent = false;
+    unsigned char* m_mapped = nullptr;
+    GLsync m_fences[FRAMES_IN_FLIGHT] = {};
+    bool m_waited = false;          // this frame's region is known to be free
+
+    void allocate(size_t region_size);
+    size_t region_start() const { return m_persistent ? m_frame * m_size : 0; }
+
+public:
+    static constexpr size_t DEFAULT_SIZE = 1 << 20;
+
+    // Once there's a GL context
+    void load(size_t size = DEFAULT_SIZE);
+
+    // Copies bytes in and leaves the buffer bound to GL_ARRAY_BUFFER. Returns the offset to
+    // hand glVertexAttribPointer. Grows if a frame writes more than fits.
+    size_t upload(const void* data, size_t bytes);
+
+    // After the last draw of the frame
+    void end_frame();
+
+    bool persistent() const { return m_persistent; }
+    int waits = 0;                  // times upload() had to block on a fence
+};
+
+extern StreamBuffer g_stream_buffer;
@@ -0,0 +1,92 @@
+//
+//  TextureAtlas.cpp
+//  exercise
+//
+
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+
+TextureAtlas::TextureAtlas(const std::vector<Image>& images, int max_page_size)
+    : m_images(images), m_placements(images.size())
+{
+    place(max_page_size);
+
+    for (Page& page : m_pages) page.pixels.assign((size_t) page.width * page.height * 4, 0);
+    for (int image = 0; image < (int) m_images.size(); image++) blit(image);
+}
+
+void TextureAtlas::place(int max_page_size)
+{
+    std::vector<int> order(m_images.size());
+    for (int i = 0; i < (int) order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_images[a].height > m_images[b].height;
+    });
+
+    int page = -1;
+    int shelf_x = 0, shelf_y = 0, shelf_height = 0;
+
+    for (int image : order) {
+        int width = m_images[image].width + 2 * PADDING;
+        int height = m_images[image].height + 2 * PADDING;
+
+        if (width > max_page_size || height > max_page_size) {
+            m_pages.push_back({ width, height, {} });
+            m_placements[image] = { (int) m_pages.size() - 1, PADDING, PADDING };
+            page = -1;      // don't go on filling around it
+            continue;
+        }
+
+        if (page >= 0 && shelf_x + width > max_page_size) {
+            shelf_y += shelf_height;
+            shelf_x = shelf_height = 0;
+        }
+        if (page < 0 || shelf_y + height > max_page_size) {
+            m_pages.push_back({});
+            page = (int) m_pages.size() - 1;
+            shelf_x = shelf_y = shelf_height = 0;
+        }
+
+        m_placements[image] = { page, shelf_x + PADDING, shelf_y + PADDING };
+        shelf_x += width;
+        shelf_height = std::max(shelf_height, height);
+
+        // pages are only as big as what's on them
+        m_pages[page].width = std::max(m_pages[page].width, shelf_x);
+        m_pages[page].height = std::max(m_pages[page].height, shelf_y + height);
+    }
+}
+
+void TextureAtlas::blit(int image)
+{
+    const Image& source = m_images[image];
+    const Placement& placement = m_placements[image];
+    Page& page = m_pages[placement.page];
+
+    auto texel = [&page](int x, int y) { return &page.pixels[((size_t) y * page.width + x) * 4]; };
+
+    for (int row = -PADDING; row < source.height + PADDING; row++) {
+        int source_row = std::min(std::max(row, 0), source.height - 1);
+        const unsigned char* from = source.pixels + (size_t) source_row * source.width * 4;
+        unsigned char* to = texel(placement.x, placement.y + row);
+
+        std::memcpy(to, from, (size_t) source.width * 4);
+        for (int x = 1; x <= PADDING; x++) {
+            std::memcpy(to - x * 4, from, 4);
+            std::memcpy(to + (source.width - 1 + x) * 4, from + (source.width - 1) * 4, 4);
+        }
+    }
+}
+
+TextureAtlas::Region TextureAtlas::region(int image) const
+{
+    const Placement& placement = m_placements[image];
+    const Page& page = m_pages[placement.page];
+
+    return { placement.page,
+             (float) placement.x / (float) page.width,
+             (float) placement.y / (float) page.height,
+             (float) m_images[image].width / (float) page.width,
+             (float) m_images[image].height / (float) page.height };
+}
@@ -0,0 +1,46 @@
+//
+//  TextureAtlas.h
+//  exercise
+//
+//  Packs RGBA images onto as few pages as will hold them, so sprites drawn one
+//  after another can share a texture. Images go onto shelves, tallest first;
+//  when a page is full the next one starts. Each image is ringed with a copy of
+//  its own edge pixels, so linear filtering at a sprite's border never picks up
+//  its neighbour. Nothing here touches GL: upload pages() and turn placements
+//  into texture coordinates with region().
+//
+
+#pragma once
+
+#include <vector>
+
+class TextureAtlas
+{
+public:
+    struct Image { const unsigned char* pixels; int width, height; };  // RGBA, top row first
+    struct Placement { int page, x, y; };   // top-left of the image itself, inside the padding
+    struct Page {
+        int width = 0, height = 0;
+        std::vector<unsigned char> pixels;
+    };
+    struct Region { int page; float u, v, width, height; };
+
+    static constexpr int PADDING = 2;   // pixels of extruded edge around every image
+
+private:
+    std::vector<Image> m_images;
+    std::vector<Placement> m_placements;
+    std::vector<Page> m_pages;
+
+    void place(int max_page_size);
+    void blit(int image);
+
+public:
+    // An image too big for max_page_size gets a page of its own, sized to fit it
+    TextureAtlas(const std::vector<Image>& images, int max_page_size);
+
+    const std::vector<Page>& pages() const { return m_pages; }
+    const Placement& placement(int image) const { return m_placements[image]; }
+
+    Region region(int image) const;     // where the image sits in its page, in texture coordinates
+};
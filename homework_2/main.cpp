@@ -14,8 +14,26 @@
 #include "ShaderProgram.h"
 #include "stb_image.h"
 #include "Entity.h"
+#include "Game.h"
+#include "Headless.h"
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "SpriteBatch.h"
+#include "SpriteInstancer.h"
+#include "TextureAtlas.h"
+#include "StreamBuffer.h"
+#include "ParticleSystem.h"
+#include "ParticleRenderer.h"
+#include "RenderQueue.h"
+#include "FramePacer.h"
+#include "GpuTimer.h"
+#include "Bloom.h"
+#include "Offscreen.h"
 #include <vector>
+#include <algorithm>
 #include <ctime>
+#include <chrono>
+#include <string>
 #include "cmath"
 
 // ————— CONSTANTS ————— //
@@ -33,39 +51,24 @@ constexpr int VIEWPORT_X = 0,
               VIEWPORT_HEIGHT = WINDOW_HEIGHT;
 
 constexpr char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
-               F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
+               F_SHADER_PATH[] = "shaders/fragment_textured.glsl",
+               V_INSTANCED_SHADER_PATH[] = "shaders/vertex_instanced.glsl",
+               F_DISCO_SHADER_PATH[] = "shaders/fragment_disco.glsl",
+               V_PARTICLE_SHADER_PATH[] = "shaders/vertex_particle.glsl",
+               F_PARTICLE_SHADER_PATH[] = "shaders/fragment_particle.glsl",
+               V_POST_SHADER_PATH[] = "shaders/vertex_post.glsl",
+               F_BRIGHT_SHADER_PATH[] = "shaders/fragment_bright.glsl",
+               F_BLUR_SHADER_PATH[] = "shaders/fragment_blur.glsl",
+               F_COMPOSITE_SHADER_PATH[] = "shaders/fragment_composite.glsl";
 
 constexpr float MILLISECONDS_IN_SECOND = 1000.0;
 
-constexpr glm::vec3 SCENE_SCALE = glm::vec3(12.0f, 12.0f, 0.0f);
-constexpr glm::vec3 SCENE_LOCATION = glm::vec3(0.0f, 0.0f, 0.0f);
+constexpr float MAX_FRAME_TIME = 0.25f;             // longer frames are dropped rather than caught up
+constexpr float OFFSCREEN_FRAME_TIME = 1.0f / 60.0f;    // simulated time per offscreen frame, so runs compare
+constexpr int DEFAULT_FRAME_RATE = 60;      // the limit without vsync, and the refresh rate when SDL can't tell
+constexpr float DISCO_BEAT = 0.75f;         // seconds, as BEAT in fragment_disco.glsl
 
-constexpr glm::vec3 MESSAGE_SCALE = glm::vec3(10.0f, 10.0f, 0.0f);
-constexpr glm::vec3 MESSAGE_LOCATION = glm::vec3(0.0f, 0.0f, 0.0f);
-
-constexpr glm::vec3 TOP_WALL_SCALE = glm::vec3(12.0f, 1.0f, 0.0f);
-constexpr glm::vec3 TOP_WALL_LOCATION = glm::vec3(0.0f, 3.9f, 0.0f);
-
-constexpr glm::vec3 BOTTOM_WALL_SCALE = glm::vec3(12.0f, 1.0f, 0.0f);
-constexpr glm::vec3 BOTTOM_WALL_LOCATION = glm::vec3(0.0f, -3.9f, 0.0f);
-
-constexpr glm::vec3 LEFT_WALL_SCALE = glm::vec3(1.0f, 8.0f, 0.0f);
-constexpr glm::vec3 LEFT_WALL_LOCATION = glm::vec3(-6.0f, 0.0f, 0.0f);
-
-constexpr glm::vec3 RIGHT_WALL_SCALE = glm::vec3(1.0f, 8.0f, 0.0f);
-constexpr glm::vec3 RIGHT_WALL_LOCATION = glm::vec3(6.0f, 0.0f, 0.0f);
-
-constexpr glm::vec3 LEFT_PADDLE_SCALE = glm::vec3(0.25f, 1.0f, 0.0f);
-constexpr glm::vec3 LEFT_PADDLE_LOCATION = glm::vec3(-4.8f, 0.0f, 0.0f);
-
-constexpr glm::vec3 RIGHT_PADDLE_SCALE = glm::vec3(0.25f, 1.0f, 0.0f);
-constexpr glm::vec3 RIGHT_PADDLE_LOCATION = glm::vec3(4.8f, 0.0f, 0.0f);
-
-constexpr glm::vec3 BALL_SCALE = glm::vec3(0.75f, 0.75f, 0.0f);
-constexpr glm::vec3 BALL_LOCATION = glm::vec3(0.0f, 0.0f, 0.0f);
-
-constexpr glm::vec3 PADDLE_SPEED = glm::vec3(0.0f, 2.0f, 0.0f);
-constexpr glm::vec3 BALL_SPEED = glm::vec3(3.0f, 0.50f, 0.0f);
+constexpr int MAX_ATLAS_PAGE_SIZE = 8192;       // further capped by what the GPU supports
 
 constexpr GLint NUMBER_OF_TEXTURES = 1,         // idk
                 LEVEL_OF_DETAIL    = 0,
@@ -74,84 +77,142 @@ constexpr GLint NUMBER_OF_TEXTURES = 1,         // idk
 // ————— STRUCTS AND ENUMS —————//
 enum AppStatus  { RUNNING, TERMINATED };
 enum FilterType { NEAREST, LINEAR     };
+enum SwapMode   { SWAP_IMMEDIATE, SWAP_VSYNC, SWAP_ADAPTIVE };   // adaptive tears a late frame instead of holding it
 
-struct GameState {  Entity* scene;
-                    Entity* message;
-                    Entity* top_wall;
-                    Entity* bottom_wall;
-                    Entity* left_wall;
-                    Entity* right_wall;
-                    Entity* left_paddle;
-                    Entity* right_paddle;
-                    Entity* ball1;
-                    Entity* ball2;
-                    Entity* ball3;
-};
-
-// ————— VARIABLES ————— //
-GameState g_game_state;
-std::vector<Entity*> ball_collidables;
-std::vector<Entity*> paddle_collidables;
-
-bool left_right;    // 0 = ball goes left to start, 1 = goes right
-bool down_up;       // 0 = ball goes down to start, 1 = goes up
-
-bool start = true;
-bool pause = true;
-glm::vec3 preserve_ball1_movement, preserve_ball2_movement, preserve_ball3_movement;
+struct TextureFile { const char* filepath; FilterType filter; };
+struct DecodedImage { unsigned char* pixels; int width, height; };
 
+// ————— VARIABLES ————— //
 SDL_Window* g_display_window;
+SDL_GLContext g_gl_context;     // current on the render thread once the game starts
 AppStatus g_app_status = RUNNING;
 
+SwapMode g_swap_mode = SWAP_VSYNC;
+int g_frame_rate_limit = 0;     // 0 to leave it to vsync, or DEFAULT_FRAME_RATE without it
+FramePacer g_frame_pacer;
+
 ShaderProgram g_shader_program;
+ShaderProgram g_instanced_program;
+ShaderProgram g_disco_program;
+ShaderProgram g_particle_program;
+ShaderProgram g_bright_program, g_composite_program;
+ShaderProgram g_blur_programs[Bloom::MAX_TAPS];     // for 1 tap, 2 taps, ...
+SpriteBatch g_sprite_batch;
+SpriteBatch g_floor_batch;      // just the scene, through g_disco_program
+SpriteInstancer g_ball_instancer;
+ParticleRenderer g_particle_renderer;
+BloomSettings g_bloom_settings;
+Bloom g_bloom;
+int g_frame_zone, g_background_zone, g_entities_zone, g_ui_zone;     // in g_gpu_timer
 glm::mat4 g_view_matrix, g_projection_matrix;
 
 float g_previous_ticks = 0.0f;
-Uint32 timeout = SDL_GetTicks();
-
-bool single_player = false;
-bool game_over = false;
+float g_accumulator = 0.0f;
+float g_disco_time = 0.0f;      // drives the floor's animation
+bool g_redraw = true;           // the window needs drawing even if the frame hasn't changed
 
 void initialize();
+void initialize_gl();
 void process_input();
 void update();
-void render();
+void advance(float delta_time);
+bool render();
+void wait_for_change();
+void draw_frame(const RenderList& list);
+void log_gpu_timing();
+void log_bloom();
 void shutdown();
 
-GLuint load_texture(const char* filepath);
-
 // ———— GENERAL FUNCTIONS ———— //
-GLuint load_texture(const char* filepath, FilterType filterType)
+// Safe to call from any thread; only the upload has to happen on the GL one
+DecodedImage decode_image(const char* filepath)
 {
-    int width, height, number_of_components;
-    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components,
-                                     STBI_rgb_alpha);
+    DecodedImage image;
+    int number_of_components;
+    image.pixels = stbi_load(filepath, &image.width, &image.height, &number_of_components,
+                             STBI_rgb_alpha);
 
-    if (image == NULL)
+    if (image.pixels == NULL)
     {
         LOG("Unable to load image. Make sure the path is correct.");
         assert(false);
     }
 
+    return image;
+}
+
+GLuint upload_texture(const unsigned char* pixels, int width, int height, FilterType filterType)
+{
     GLuint textureID;
     glGenTextures(NUMBER_OF_TEXTURES, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    g_gl_state.bind_texture(textureID);
     glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER,
-                 GL_RGBA, GL_UNSIGNED_BYTE, image);
+                 GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
                     filterType == NEAREST ? GL_NEAREST : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
                     filterType == NEAREST ? GL_NEAREST : GL_LINEAR);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    stbi_image_free(image);
+    // sprites are rectangles inside a page, so wrapping would only ever sample a neighbour
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     return textureID;
 }
 
+// Decodes every file at once on g_jobs, then packs them into atlas pages (one set per
+// filter type, since that's a property of the texture) and uploads those. Returns where
+// each file ended up, in order.
+std::vector<SpriteFrame> load_atlas(const std::vector<TextureFile>& files)
+{
+    std::vector<DecodedImage> images(files.size());
+    g_jobs.parallel_for((int) files.size(), 1, [&](int begin, int end, int /*lane*/) {
+        for (int i = begin; i < end; i++) images[i] = decode_image(files[i].filepath);
+    });
+
+    GLint max_texture_size;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+    int page_size = std::min((int) max_texture_size, MAX_ATLAS_PAGE_SIZE);
+
+    std::vector<SpriteFrame> regions(files.size());
+    for (FilterType filter : { NEAREST, LINEAR }) {
+        std::vector<int> indices;
+        std::vector<TextureAtlas::Image> filtered;
+        for (size_t i = 0; i < files.size(); i++) {
+            if (files[i].filter != filter) continue;
+            indices.push_back((int) i);
+            filtered.push_back({ images[i].pixels, images[i].width, images[i].height });
+        }
+        if (filtered.empty()) continue;
+
+        TextureAtlas atlas(filtered, page_size);
+
+        std::vector<GLuint> page_ids;
+        for (const TextureAtlas::Page& page : atlas.pages()) {
+            page_ids.push_back(upload_texture(page.pixels.data(), page.width, page.height, filter));
+        }
+
+        for (size_t i = 0; i < indices.size(); i++) {
+            TextureAtlas::Region region = atlas.region((int) i);
+            regions[indices[i]] = { page_ids[region.page], region.u, region.v, region.width, region.height };
+        }
+    }
+
+    for (DecodedImage& image : images) stbi_image_free(image.pixels);
+    return regions;
+}
+
+void make_window_current(bool current)
+{
+    SDL_GL_MakeCurrent(g_display_window, current ? g_gl_context : nullptr);
+}
+
+void present_window()
+{
+    SDL_GL_SwapWindow(g_display_window);
+}
+
 void initialize()
 {
     SDL_Init(SDL_INIT_VIDEO);
@@ -160,8 +221,8 @@ void initialize()
                                       WINDOW_WIDTH, WINDOW_HEIGHT,
                                       SDL_WINDOW_OPENGL);
 
-    SDL_GLContext context = SDL_GL_CreateContext(g_display_window);
-    SDL_GL_MakeCurrent(g_display_window, context);
+    g_gl_context = SDL_GL_CreateContext(g_display_window);
+    SDL_GL_MakeCurrent(g_display_window, g_gl_context);
 
     if (g_display_window == nullptr)
     {
@@ -169,13 +230,78 @@ void initialize()
         shutdown();
     }
 
+    // not every driver does adaptive sync; plain vsync is the next best thing
+    int interval = g_swap_mode == SWAP_ADAPTIVE ? -1 : g_swap_mode == SWAP_VSYNC ? 1 : 0;
+    if (SDL_GL_SetSwapInterval(interval) != 0 && interval == -1) SDL_GL_SetSwapInterval(1);
+    bool synced = SDL_GL_GetSwapInterval() != 0;
+
+    // with vsync the swap holds the loop back and the pacer only watches for late frames;
+    // without it nothing else would stop the loop pinning a core
+    if (g_frame_rate_limit > 0 || !synced) {
+        g_frame_pacer.start(g_frame_rate_limit > 0 ? g_frame_rate_limit : DEFAULT_FRAME_RATE, true);
+    }
+    else {
+        SDL_DisplayMode mode;
+        bool known = SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(g_display_window), &mode) == 0 &&
+                     mode.refresh_rate > 0;
+        g_frame_pacer.start(known ? mode.refresh_rate : DEFAULT_FRAME_RATE, false);
+    }
+
+    initialize_gl();
+
+    // from here on only the render thread touches GL
+    make_window_current(false);
+    g_render_thread.start({ make_window_current, present_window }, draw_frame);
+}
+
+// Shaders, textures and game objects, with a context current
+void initialize_gl()
+{
 #ifdef _WINDOWS
     glewInit();
 #endif
 
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
 
-    g_shader_program.load(V_SHADER_PATH, F_SHADER_PATH);
+    // linked shaders are kept next to the executable so later launches skip compiling
+    char* base_path = SDL_GetBasePath();
+    if (base_path != nullptr) {
+        ShaderProgram::binary_cache_directory = base_path;
+        SDL_free(base_path);
+    }
+
+    // without instancing the balls go through the sprite batch like everything else, and
+    // particles, which have nothing to fall back on, aren't drawn
+    g_gl_state.load();
+    if (!g_gl_state.instancing()) LOG("No instanced drawing on this driver; balls are batched instead and there are no sparkles");
+
+    // both programs compile while the textures decode; neither is waited on until first use
+    g_shader_program.begin_load(V_SHADER_PATH, F_SHADER_PATH);
+    if (g_gl_state.instancing()) g_instanced_program.begin_load(V_INSTANCED_SHADER_PATH, F_SHADER_PATH);
+    g_disco_program.begin_load(V_SHADER_PATH, F_DISCO_SHADER_PATH);
+    if (g_gl_state.instancing()) g_particle_program.begin_load(V_PARTICLE_SHADER_PATH, F_PARTICLE_SHADER_PATH);
+    if (g_bloom_settings.enabled) {
+        g_bright_program.begin_load(V_POST_SHADER_PATH, F_BRIGHT_SHADER_PATH);
+        for (int taps = 1; taps <= g_bloom_settings.taps; taps++) {
+            g_blur_programs[taps - 1].begin_load(V_POST_SHADER_PATH, F_BLUR_SHADER_PATH,
+                                                 "#define TAPS " + std::to_string(taps) + "\n");
+        }
+        g_composite_program.begin_load(V_POST_SHADER_PATH, F_COMPOSITE_SHADER_PATH);
+    }
+    g_stream_buffer.load();
+    g_gpu_timer.load();
+
+    glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
+
+    // ————— GENERATE OBJECTS ————— //
+    
+    std::vector<SpriteFrame> regions = load_atlas({
+        { "assets/start_screen.png", LINEAR },
+        { "assets/left_win.png", LINEAR },
+        { "assets/right_win.png", LINEAR },
+        { "assets/box.png", NEAREST },
+        { "assets/ball.png", NEAREST }
+    });
 
     g_view_matrix       = glm::mat4(1.0f);
     g_projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
@@ -183,228 +309,38 @@ void initialize()
     g_shader_program.set_projection_matrix(g_projection_matrix);
     g_shader_program.set_view_matrix(g_view_matrix);
 
-    glUseProgram(g_shader_program.get_program_id());
+    if (g_gl_state.instancing()) {
+        g_instanced_program.set_projection_matrix(g_projection_matrix);
+        g_instanced_program.set_view_matrix(g_view_matrix);
+        g_ball_instancer.load(&g_instanced_program);
+    }
 
-    glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
+    g_disco_program.set_projection_matrix(g_projection_matrix);
+    g_disco_program.set_view_matrix(g_view_matrix);
 
-    // ————— GENERATE OBJECTS ————— //
-    
-    std::vector<GLuint> message_textures_ids = {
-        load_texture("/Users/Sage/Downloads/Game Programming/disco_pong/homework_2/assets/start_screen.png", LINEAR),
-        load_texture("/Users/Sage/Downloads/Game Programming/disco_pong/homework_2/assets/left_win.png", LINEAR),
-        load_texture("/Users/Sage/Downloads/Game Programming/disco_pong/homework_2/assets/right_win.png", LINEAR)
-    };
-    
-    std::vector<GLuint> scene_textures_ids = {
-        load_texture("/Users/Sage/Downloads/Game Programming/disco_pong/homework_2/assets/disco_floor_1.png", LINEAR),
-        load_texture("/Users/Sage/Downloads/Game Programming/disco_pong/homework_2/assets/disco_floor_2.png", LINEAR)
-    };
-    
-    std::vector<GLuint> box_textures_ids = {
-        load_texture("/Users/Sage/Downloads/Game Programming/disco_pong/homework_2/assets/box.png", NEAREST)
-    };
-    
-    std::vector<GLuint> ball_textures_ids = {
-        load_texture("/Users/Sage/Downloads/Game Programming/disco_pong/homework_2/assets/ball.png", NEAREST)
-    };
-    
-    
-    std::vector<std::vector<int>> entity_animations = { {0}, {0}, {0} };
-    
-    g_game_state.message = new Entity(
-        message_textures_ids,  // a list of texture IDs
-        glm::vec3(0.0f),     // translation speed
-        entity_animations,   // list of animation frames for each type of animation
-        0.0f,                // animation time
-        1,                   // number of frames for animation
-        0,                   // current frame index
-        1,                   // current animation col amount
-        1,                   // current animation row amount
-        SPRITE1              // current animation
-    );
-
-    g_game_state.scene = new Entity(
-        scene_textures_ids,  // a list of texture IDs
-        glm::vec3(0.0f),     // translation speed
-        entity_animations,   // list of animation frames for each type of animation
-        0.0f,                // animation time
-        1,                   // number of frames for animation
-        0,                   // current frame index
-        1,                   // current animation col amount
-        1,                   // current animation row amount
-        SPRITE1              // current animation
-    );
-    
-    g_game_state.top_wall = new Entity(
-        box_textures_ids,      // a list of texture IDs
-        glm::vec3(0.0f),        // translation speed
-        entity_animations,      // list of animation frames for each type of animation
-        0.0f,                   // animation time
-        1,                      // number of frames
-        0,                      // current frame index
-        1,                      // current animation col amount
-        1,                      // current animation row amount
-        SPRITE1                 // current animation
-    );
-    
-    g_game_state.bottom_wall = new Entity(
-        box_textures_ids,      // a list of texture IDs
-        glm::vec3(0.0f),        // translation speed
-        entity_animations,      // list of animation frames for each type of animation
-        0.0f,                   // animation time
-        1,                      // number of frames
-        0,                      // current frame index
-        1,                      // current animation col amount
-        1,                      // current animation row amount
-        SPRITE1                 // current animation
-    );
-    
-    g_game_state.left_wall = new Entity(
-        box_textures_ids,      // a list of texture IDs
-        glm::vec3(0.0f),        // translation speed
-        entity_animations,      // list of animation frames for each type of animation
-        0.0f,                   // animation time
-        1,                      // number of frames
-        0,                      // current frame index
-        1,                      // current animation col amount
-        1,                      // current animation row amount
-        SPRITE1                 // current animation
-    );
-    
-    g_game_state.right_wall = new Entity(
-        box_textures_ids,      // a list of texture IDs
-        glm::vec3(0.0f),        // translation speed
-        entity_animations,      // list of animation frames for each type of animation
-        0.0f,                   // animation time
-        1,                      // number of frames
-        0,                      // current frame index
-        1,                      // current animation col amount
-        1,                      // current animation row amount
-        SPRITE1                 // current animation
-    );
-    
-    g_game_state.left_paddle = new Entity(
-        box_textures_ids,            // a list of texture IDs
-        glm::vec3(0.0f, 1.0f, 0.0f),    // translation speed
-        entity_animations,              // list of animation frames for each type of animation
-        0.0f,                        // animation time
-        1,                           // number of frames
-        0,                           // current frame index
-        1,                           // current animation col amount
-        1,                           // current animation row amount
-        SPRITE1                      // current animation
-    );
-    
-    g_game_state.right_paddle = new Entity(
-        box_textures_ids,            // a list of texture IDs
-        glm::vec3(0.0f, 1.0f, 0.0f),    // translation speed
-        entity_animations,              // list of animation frames for each type of animation
-        0.0f,                   // animation time
-        1,                      // number of frames
-        0,                      // current frame index
-        1,                      // current animation col amount
-        1,                      // current animation row amount
-        SPRITE1                 // current animation
-    );
-    
-    g_game_state.ball1 = new Entity(
-        ball_textures_ids,              // a list of texture IDs
-        glm::vec3(1.0f, 0.25f, 0.0f),   // translation speed
-        entity_animations,              // list of animation frames for each type of animation
-        0.0f,                   // animation time
-        1,                      // number of frames
-        0,                      // current frame index
-        1,                      // current animation col amount
-        1,                      // current animation row amount
-        SPRITE1                 // current animation
-    );
-    
-    g_game_state.ball2 = new Entity(
-        ball_textures_ids,              // a list of texture IDs
-        glm::vec3(1.0f, 0.25f, 0.0f),   // translation speed
-        entity_animations,              // list of animation frames for each type of animation
-        0.0f,                   // animation time
-        1,                      // number of frames
-        0,                      // current frame index
-        1,                      // current animation col amount
-        1,                      // current animation row amount
-        SPRITE1                 // current animation
-    );
-    
-    g_game_state.ball3 = new Entity(
-        ball_textures_ids,              // a list of texture IDs
-        glm::vec3(1.0f, 0.25f, 0.0f),   // translation speed
-        entity_animations,              // list of animation frames for each type of animation
-        0.0f,                   // animation time
-        1,                      // number of frames
-        0,                      // current frame index
-        1,                      // current animation col amount
-        1,                      // current animation row amount
-        SPRITE1                 // current animation
-    );
-    
-    ball_collidables.push_back(g_game_state.top_wall);
-    ball_collidables.push_back(g_game_state.bottom_wall);
-    ball_collidables.push_back(g_game_state.left_paddle);
-    ball_collidables.push_back(g_game_state.right_paddle);
-    ball_collidables.push_back(g_game_state.left_wall);
-    ball_collidables.push_back(g_game_state.right_wall);
-    
-    paddle_collidables.push_back(g_game_state.top_wall);
-    paddle_collidables.push_back(g_game_state.bottom_wall);
-    
-    g_game_state.message->set_position(MESSAGE_LOCATION);
-    g_game_state.message->set_scale(MESSAGE_SCALE);
-    g_game_state.message->set_visibility(true);
-    
-    g_game_state.scene->set_position(SCENE_LOCATION);
-    g_game_state.scene->set_scale(SCENE_SCALE);
-    
-    g_game_state.top_wall->set_position(TOP_WALL_LOCATION);
-    g_game_state.top_wall->set_scale(TOP_WALL_SCALE);
-    g_game_state.top_wall->set_shape(TOP_WALL);
-    
-    g_game_state.bottom_wall->set_position(BOTTOM_WALL_LOCATION);
-    g_game_state.bottom_wall->set_scale(BOTTOM_WALL_SCALE);
-    g_game_state.bottom_wall->set_shape(BOTTOM_WALL);
-    
-    g_game_state.left_wall->set_position(LEFT_WALL_LOCATION);
-    g_game_state.left_wall->set_scale(LEFT_WALL_SCALE);
-    g_game_state.left_wall->set_shape(SIDE_WALL);
-    
-    g_game_state.right_wall->set_position(RIGHT_WALL_LOCATION);
-    g_game_state.right_wall->set_scale(RIGHT_WALL_SCALE);
-    g_game_state.right_wall->set_shape(SIDE_WALL);
-    
-    g_game_state.left_paddle->set_position(LEFT_PADDLE_LOCATION);
-    g_game_state.left_paddle->set_scale(LEFT_PADDLE_SCALE);
-    g_game_state.left_paddle->set_shape(LEFT_PADDLE);
-    g_game_state.left_paddle->set_speed(PADDLE_SPEED);
-    
-    g_game_state.right_paddle->set_position(RIGHT_PADDLE_LOCATION);
-    g_game_state.right_paddle->set_scale(RIGHT_PADDLE_SCALE);
-    g_game_state.right_paddle->set_shape(RIGHT_PADDLE);
-    g_game_state.right_paddle->set_speed(PADDLE_SPEED);
+    if (g_gl_state.instancing()) {
+        g_particle_program.set_projection_matrix(g_projection_matrix);
+        g_particle_program.set_view_matrix(g_view_matrix);
+        g_particle_renderer.load(&g_particle_program);
+    }
+
+    g_frame_zone      = g_gpu_timer.add_zone("frame");
+    g_background_zone = g_gpu_timer.add_zone("background");
+    g_entities_zone   = g_gpu_timer.add_zone("entities");
+    g_ui_zone         = g_gpu_timer.add_zone("ui");
+
+    g_bloom.load(VIEWPORT_WIDTH, VIEWPORT_HEIGHT, g_bloom_settings,
+                 &g_bright_program, g_blur_programs, &g_composite_program);
+
+    g_shader_program.use();
     
-    g_game_state.ball1->set_position(BALL_LOCATION);
-    g_game_state.ball1->set_scale(BALL_SCALE);
-    g_game_state.ball1->set_shape(BALL);
-    g_game_state.ball1->set_rotation(0.5f);
-    g_game_state.ball1->set_speed(BALL_SPEED);
+    std::vector<SpriteFrame> message_regions = { regions[0], regions[1], regions[2] };
+    std::vector<SpriteFrame> scene_regions   = { { 0, 0.0f, 0.0f, 1.0f, 1.0f } };  // the floor shader tiles it by itself
+    std::vector<SpriteFrame> box_regions     = { regions[3] };
+    std::vector<SpriteFrame> ball_regions    = { regions[4] };
     
-    g_game_state.ball2->set_position(BALL_LOCATION);
-    g_game_state.ball2->set_scale(BALL_SCALE);
-    g_game_state.ball2->set_shape(BALL);
-    g_game_state.ball2->set_rotation(-0.75f);
-    g_game_state.ball2->set_visibility(false);
-    g_game_state.ball2->set_speed(BALL_SPEED);
     
-    g_game_state.ball3->set_position(BALL_LOCATION);
-    g_game_state.ball3->set_scale(BALL_SCALE);
-    g_game_state.ball3->set_shape(BALL);
-    g_game_state.ball3->set_rotation(0.35f);
-    g_game_state.ball3->set_visibility(false);
-    g_game_state.ball3->set_speed(BALL_SPEED);
+    initialize_game({ message_regions, scene_regions, box_regions, ball_regions });
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -421,6 +357,10 @@ void process_input() {
                 g_app_status = TERMINATED;
                 break;
 
+            case SDL_WINDOWEVENT:   // exposed, resized and so on
+                g_redraw = true;
+                break;
+
             case SDL_KEYDOWN:
                 switch (event.key.keysym.sym) {
                     case SDLK_q: g_app_status = TERMINATED;
@@ -435,73 +375,21 @@ void process_input() {
                     }
                         
                     case SDLK_SPACE: {
-                        if (start) {
-                            g_game_state.message->set_visibility(false);  // hide start screen
-                            float left_right = static_cast<float>((rand() % 2) == 0 ? -1.0 : 1.0);
-                            float down_up = static_cast<float>((rand() % 2) == 0 ? -1.0 : 1.0);
-                            g_game_state.ball1->set_movement(glm::vec3(left_right, down_up, 0.0f));
-                            start = false;  // already started, can't start again until next game
-                        }
-                        
-                        else if (pause) {
-                            // preserve speed for unpause
-                            preserve_ball1_movement = g_game_state.ball1->get_movement();
-                            preserve_ball2_movement = g_game_state.ball2->get_movement();
-                            preserve_ball3_movement = g_game_state.ball3->get_movement();
-                            
-                            // halt paddles and ball
-                            g_game_state.ball1->set_movement(glm::vec3(0.0f));
-                            g_game_state.ball2->set_movement(glm::vec3(0.0f));
-                            g_game_state.ball3->set_movement(glm::vec3(0.0f));
-                            g_game_state.left_paddle->set_can_move(false);
-                            g_game_state.right_paddle->set_can_move(false);
-                            pause = false;  // already paused, can't pause again until resumed
-                        }
-                        
-                        else {  // resume
-                            g_game_state.ball1->set_movement(preserve_ball1_movement);
-                            g_game_state.ball2->set_movement(preserve_ball2_movement);
-                            g_game_state.ball3->set_movement(preserve_ball3_movement);
-                            g_game_state.left_paddle->set_can_move(true);
-                            g_game_state.right_paddle->set_can_move(true);
-                            pause = true;   // next time we hit space we can pause again
-                        }
-                            
+                        if (!start_game()) toggle_pause();
                         break;
                     }
                         
-                    case SDLK_1: {
-                        g_game_state.ball2->set_movement(glm::vec3(0.0f));
-                        g_game_state.ball3->set_movement(glm::vec3(0.0f));
-                        g_game_state.ball2->set_visibility(false);
-                        g_game_state.ball3->set_visibility(false);
+                    case SDLK_1: set_ball_count(1);
                         break;
-                    }
                     
-                    case SDLK_2: {
-                        if (!g_game_state.ball2->get_visibility()) {
-                            g_game_state.ball2->set_movement(-1.5f * g_game_state.ball1->get_movement());
-                            g_game_state.ball2->set_visibility(true);
-                        }
-                        g_game_state.ball3->set_movement(glm::vec3(0.0f));
-                        g_game_state.ball3->set_visibility(false);
+                    case SDLK_2: set_ball_count(2);
                         break;
-                    }
                         
-                    case SDLK_3: {
-                        if (!g_game_state.ball2->get_visibility()) {
-                            g_game_state.ball2->set_movement(-1.5f * g_game_state.ball1->get_movement());
-                            g_game_state.ball2->set_visibility(true);
-                        }
-                
-                        if (!g_game_state.ball3->get_visibility()) {
-                            g_game_state.ball3->set_movement(glm::vec3(-0.9f * g_game_state.ball1->get_movement()[0],
-                                                                       1.25f * g_game_state.ball1->get_movement()[1],
-                                                                       0.0f));
-                            g_game_state.ball3->set_visibility(true);
-                        }
+                    case SDLK_3: set_ball_count(3);
+                        break;
+                        
+                    case SDLK_EQUALS: set_ball_count(2 * (int) g_game_state.balls.size());   // stress test
                         break;
-                    }
             
                     default:
                         break;
@@ -539,98 +427,315 @@ void update()
     float delta_time = ticks - g_previous_ticks;
     g_previous_ticks = ticks;
 
-    if (SDL_TICKS_PASSED(SDL_GetTicks(), timeout)) {
-        if (g_game_state.scene->get_animation() == SPRITE1) {
-            g_game_state.scene->set_animation_state(SPRITE2);
-        }
-        else {
-            g_game_state.scene->set_animation_state(SPRITE1);
-        }
-        timeout = SDL_GetTicks() + 750;
-    }
+    advance(delta_time);
+}
+
+// Everything a frame does once it's known how much time has passed
+void advance(float delta_time)
+{
+    g_disco_time += delta_time;
     
-    if (single_player) {
-        if (g_game_state.ball1->get_position()[1] > g_game_state.left_paddle->get_position()[1]) {
-            g_game_state.left_paddle->set_movement(glm::vec3(0.0f, 1.0f, 0.0f));
-        }
-        else {
-            g_game_state.left_paddle->set_movement(glm::vec3(0.0f, -1.0f, 0.0f));
-        }
-//        g_game_state.left_paddle->set_movement(glm::vec3(0.0f, g_game_state.left_paddle->get_movement()[1], 0.0f));
-    }
+    // run as many fixed steps as real time allows, then draw partway between the last two
+    g_accumulator += glm::min(delta_time, MAX_FRAME_TIME);
     
-    // see if anyone's lost since we last checked
-    if (g_game_state.left_wall->get_loser() && !game_over) {
-        g_game_state.message->set_animation_state(SPRITE3);
-        g_game_state.message->set_visibility(true);
-        game_over = true;
+    while (g_accumulator >= FIXED_TIMESTEP) {
+        g_entity_store.save_previous();
+        simulate(FIXED_TIMESTEP);
+        g_accumulator -= FIXED_TIMESTEP;
     }
     
-    if (g_game_state.right_wall->get_loser() && !game_over) {
-        g_game_state.message->set_animation_state(SPRITE2);
-        g_game_state.message->set_visibility(true);
-        game_over = true;
+    g_entity_store.interpolate(g_accumulator / FIXED_TIMESTEP);
+
+    // sparkles only need to move once per frame, not once per step
+    g_particles.spawn_from(g_entity_store.events);
+    g_particles.update(glm::min(delta_time, MAX_FRAME_TIME));
+}
+
+// Records the frame for the render thread; no GL happens here. Returns false when the frame
+// was the same as the last one and so wasn't drawn.
+bool render()
+{
+    RenderList& list = g_render_thread.begin_frame();
+
+    // with nothing else moving the floor steps once a beat instead of shimmering, so
+    // frames in between come out the same and needn't be drawn
+    list.set_time(game_idle() ? floorf(g_disco_time / DISCO_BEAT) * DISCO_BEAT : g_disco_time);
+
+    g_game_state.scene->render(list, LAYER_SCENE, PIPELINE_DISCO_FLOOR);
+    g_game_state.top_wall->render(list, LAYER_FIELD);
+    g_game_state.bottom_wall->render(list, LAYER_FIELD);
+    g_game_state.left_paddle->render(list, LAYER_FIELD);
+    g_game_state.right_paddle->render(list, LAYER_FIELD);
+    g_entity_store.render(g_game_state.balls, list, LAYER_BALLS,
+                          g_gl_state.instancing() ? PIPELINE_INSTANCED : PIPELINE_BATCHED);
+    if (g_particles.count() > 0 && g_gl_state.instancing()) {
+        g_particles.pack(list.particles);
+        list.push(LAYER_PARTICLES, PIPELINE_PARTICLES, SpriteFrame(), glm::mat4(1.0f));
+    }
+    g_game_state.left_wall->render(list, LAYER_GOALS);
+    g_game_state.right_wall->render(list, LAYER_GOALS);
+    g_game_state.message->render(list, LAYER_MESSAGE);
+
+    if (g_redraw) {
+        g_redraw = false;
+        g_render_thread.submit();
+        return true;
     }
-        
-    g_game_state.scene->update(delta_time);
-    g_game_state.top_wall->update(delta_time);
-    g_game_state.bottom_wall->update(delta_time);
-    g_game_state.left_paddle->update(delta_time, paddle_collidables, paddle_collidables.size());
-    g_game_state.right_paddle->update(delta_time, paddle_collidables, paddle_collidables.size());
-    g_game_state.ball1->update(delta_time, ball_collidables, ball_collidables.size());
-    g_game_state.ball2->update(delta_time, ball_collidables, ball_collidables.size());
-    g_game_state.ball3->update(delta_time, ball_collidables, ball_collidables.size());
-    g_game_state.left_wall->update(delta_time);
-    g_game_state.right_wall->update(delta_time);
-    g_game_state.message->update(delta_time);
+    return g_render_thread.submit_if_changed();
+}
+
+// After a frame that didn't change: sleeps until there's input or the floor's next beat
+void wait_for_change()
+{
+    float ticks = (float) SDL_GetTicks() / MILLISECONDS_IN_SECOND;
+    float next_beat = (floorf(g_disco_time / DISCO_BEAT) + 1.0f) * DISCO_BEAT;
+    SDL_WaitEventTimeout(nullptr, (int) ceilf((next_beat - g_disco_time) * MILLISECONDS_IN_SECOND));
+
+    // the game stood still meanwhile; only the floor's clock should see the time pass, or a
+    // paddle would jump by everything it missed as soon as a key woke us
+    float waited = (float) SDL_GetTicks() / MILLISECONDS_IN_SECOND - ticks;
+    g_disco_time += waited;
+    g_previous_ticks += waited;
+    g_frame_pacer.resync();
 }
 
-void render()
+// Runs on the render thread, with the list already sorted
+void draw_frame(const RenderList& list)
 {
+    g_gl_state.reset_counters();    // so after this, they cover exactly one frame
+    g_gpu_timer.begin(g_frame_zone);
+    g_bloom.begin();
     glClear(GL_COLOR_BUFFER_BIT);
 
-    g_game_state.scene->render(&g_shader_program);
-    g_game_state.top_wall->render(&g_shader_program);
-    g_game_state.bottom_wall->render(&g_shader_program);
-    g_game_state.left_paddle->render(&g_shader_program);
-    g_game_state.right_paddle->render(&g_shader_program);
-    g_game_state.ball1->render(&g_shader_program);
-    g_game_state.ball2->render(&g_shader_program);
-    g_game_state.ball3->render(&g_shader_program);
-    g_game_state.left_wall->render(&g_shader_program);
-    g_game_state.right_wall->render(&g_shader_program);
-    g_game_state.message->render(&g_shader_program);
+    g_sprite_batch.begin(&g_shader_program);
+    g_ball_instancer.begin();
+    g_floor_batch.begin(&g_disco_program);
+    g_disco_program.set_time(list.time());
+
+    int zone = -1;
+
+    for (int i = 0; i < list.size(); i++) {
+        const RenderCommand& command = list.command(i);
+        const SpriteFrame& frame = command.frame;
+        RenderPipeline pipeline = list.pipeline(i);
+
+        // layers are sorted, so each zone comes once; a zone only times what's drawn inside
+        // it, so everything batched so far goes down before it closes
+        RenderLayer layer = list.layer(i);
+        int layer_zone = layer == LAYER_SCENE ? g_background_zone : layer == LAYER_MESSAGE ? g_ui_zone : g_entities_zone;
+        if (layer_zone != zone) {
+            g_sprite_batch.flush();
+            g_ball_instancer.flush();
+            g_floor_batch.flush();
+            if (zone >= 0) g_gpu_timer.end(zone);
+            g_gpu_timer.begin(zone = layer_zone);
+        }
 
-    SDL_GL_SwapWindow(g_display_window);
+        // whichever ones aren't drawing this have to put down what they have first, to keep the layering
+        if (pipeline != PIPELINE_BATCHED) g_sprite_batch.flush();
+        if (pipeline != PIPELINE_INSTANCED) g_ball_instancer.flush();
+        if (pipeline != PIPELINE_DISCO_FLOOR) g_floor_batch.flush();
+
+        switch (pipeline) {
+            case PIPELINE_INSTANCED:
+                g_ball_instancer.draw(frame.texture, command.model_matrix(), frame.u, frame.v, frame.width, frame.height);
+                break;
+            case PIPELINE_DISCO_FLOOR:
+                g_floor_batch.draw(frame.texture, command.model_matrix(), frame.u, frame.v, frame.width, frame.height);
+                break;
+            case PIPELINE_PARTICLES:
+                g_particle_renderer.draw(list.particles);
+                break;
+            default:
+                g_sprite_batch.draw(frame.texture, command.model_matrix(), frame.u, frame.v, frame.width, frame.height);
+                break;
+        }
+    }
+
+    g_floor_batch.end();
+    g_ball_instancer.end();
+    g_sprite_batch.end();
+    if (zone >= 0) g_gpu_timer.end(zone);
+
+    g_bloom.end();
+    g_gpu_timer.end(g_frame_zone);
+    g_stream_buffer.end_frame();
+    g_gpu_timer.end_frame();
+}
+
+// Every zone's GPU time, averaged over the last few dozen frames. Only once the render thread's stopped.
+void log_gpu_timing()
+{
+    if (!g_gpu_timer.supported()) {
+        LOG("gpu: no timer queries on this driver");
+        return;
+    }
+
+    std::string zones;
+    for (int zone = 0; zone < g_gpu_timer.zone_count(); zone++) {
+        if (!g_gpu_timer.measured(zone)) continue;
+
+        char entry[64];
+        snprintf(entry, sizeof(entry), "%s%s %.2f", zones.empty() ? "" : ", ", g_gpu_timer.name(zone).c_str(),
+                 g_gpu_timer.milliseconds(zone));
+        zones += entry;
+    }
+    if (zones.empty()) {
+        LOG("gpu: timer queries gave no results");
+        return;
+    }
+    LOG("gpu ms per frame: " << zones << (g_gpu_timer.nests() ? "" : " (no timestamps, so nothing inside the frame)"));
+}
+
+void log_bloom()
+{
+    if (!g_bloom.enabled()) return;
+
+    LOG("bloom: 1/" << g_bloom.downsample() << " size, " << g_bloom.taps() << " taps");
 }
 
 
 void shutdown()
 {
+    g_render_thread.stop();     // first, so the GPU timings are final
+
+    const FramePacer::Stats& stats = g_frame_pacer.stats();
+    if (stats.frames > 0) {
+        LOG("frames: " << stats.frames << " at " << stats.frames / stats.total_time << " fps average, "
+            << stats.missed << " missed " << g_frame_pacer.frame_rate() << " fps deadlines ("
+            << (g_frame_pacer.limiting() ? "limited" : "vsync") << "), worst by "
+            << stats.worst_late * MILLISECONDS_IN_SECOND << " ms");
+        log_gpu_timing();
+        log_bloom();
+    }
+
     SDL_Quit();
-    delete   g_game_state.scene;
-    delete   g_game_state.message;
-    delete   g_game_state.top_wall;
-    delete   g_game_state.bottom_wall;
-    delete   g_game_state.left_wall;
-    delete   g_game_state.right_wall;
-    delete   g_game_state.left_paddle;
-    delete   g_game_state.right_paddle;
-    delete   g_game_state.ball1;
-    delete   g_game_state.ball2;
-    delete   g_game_state.ball3;
+    shutdown_game();
 }
 
 
+#ifdef OFFSCREEN
+void make_offscreen_current(bool current)
+{
+    g_offscreen.make_current(current);
+}
+
+std::string g_dump_directory;           // empty for no dumps
+int g_frames_presented = 0;
+
+void present_offscreen()
+{
+    if (!g_dump_directory.empty()) {
+        char name[32];
+        snprintf(name, sizeof(name), "/frame_%05d.ppm", g_frames_presented);
+        if (!g_offscreen.dump(g_dump_directory + name)) LOG("Couldn't write " << g_dump_directory + name);
+    }
+    glFinish();     // so the timing covers the GPU's work, not just queueing it
+    g_frames_presented++;
+}
+
+// Plays the normal update and render loop into an offscreen framebuffer, with the game
+// started and a fixed amount of simulated time per frame:
+//     ./homework_2 --offscreen [frames] [balls] [dump_directory] [options]
+int run_offscreen(int argc, char* argv[])
+{
+    int frames = argc > 0 ? atoi(argv[0]) : 600;
+    int ball_count = argc > 1 ? atoi(argv[1]) : 1;
+    g_dump_directory = argc > 2 ? argv[2] : "";
+
+    if (frames < 1) {
+        std::cerr << "Error: usage is --offscreen [frames] [balls] [dump_directory] [options], with at least 1 frame.\n";
+        return 1;
+    }
+
+    if (!g_offscreen.create(WINDOW_WIDTH, WINDOW_HEIGHT)) return 1;
+    initialize_gl();
+
+    start_game();
+    set_ball_count(ball_count);
+
+    make_offscreen_current(false);
+    g_render_thread.start({ make_offscreen_current, present_offscreen }, draw_frame);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        advance(OFFSCREEN_FRAME_TIME);
+        g_redraw = true;    // every frame costs a draw here, even once the game's over
+        render();
+    }
+    g_render_thread.stop();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "offscreen: " << g_frames_presented << " frames, " << ball_count << " balls, "
+              << seconds * 1000.0 / frames << " ms/frame (" << frames / seconds << " fps)\n"
+              << "           last frame: " << g_gl_state.issued << " GL calls issued, "
+              << g_gl_state.elided << " elided\n";
+    log_gpu_timing();
+    log_bloom();
+
+    shutdown_game();
+    g_offscreen.destroy();
+    return 0;
+}
+#endif
+
+// Reads "--option value" pairs from argv[first] on, reporting any it can't use. Returns
+// false if there were any.
+bool read_options(int argc, char* argv[], int first)
+{
+    bool bad_options = false;
+    for (int i = first; i < argc; i += 2) {
+        std::string option = argv[i];
+        if (i + 1 == argc) {
+            std::cerr << "Error: " << option << " needs a value.\n";
+            bad_options = true;
+            break;
+        }
+
+        std::string value = argv[i + 1];
+        if (option == "--vsync") g_swap_mode = value == "off" ? SWAP_IMMEDIATE : value == "adaptive" ? SWAP_ADAPTIVE : SWAP_VSYNC;
+        else if (option == "--fps") g_frame_rate_limit = std::max(atoi(value.c_str()), 0);
+        else if (option == "--bloom") {
+            g_bloom_settings.enabled = value != "off";
+            g_bloom_settings.downsample = value == "quarter" ? 4 : 2;
+        }
+        else if (option == "--bloom-taps") g_bloom_settings.taps = std::min(std::max(atoi(value.c_str()), 1), Bloom::MAX_TAPS);
+        else if (option == "--bloom-budget") g_bloom_settings.budget = (float) atof(value.c_str());
+        else {
+            std::cerr << "Error: unknown option " << option << ".\n";
+            bad_options = true;
+        }
+    }
+    return !bad_options;
+}
+
 int main(int argc, char* argv[])
 {
+    if (argc > 1 && std::string(argv[1]) == "--headless") return run_headless(argc - 2, argv + 2);
+    if (argc > 1 && std::string(argv[1]) == "--bench") return run_benchmarks(argc - 2, argv + 2);
+#ifdef OFFSCREEN
+    if (argc > 1 && std::string(argv[1]) == "--offscreen") {
+        // up to three positional arguments, then the same options as a windowed run
+        int positional = 0;
+        while (positional < 3 && 2 + positional < argc && std::string(argv[2 + positional]).rfind("--", 0) != 0)
+            positional++;
+        if (!read_options(argc, argv, 2 + positional)) return 1;
+        return run_offscreen(positional, argv + 2);
+    }
+#endif
+    
+    //     ./homework_2 [--vsync on|off|adaptive] [--fps rate] [--bloom off|half|quarter]
+    //                  [--bloom-taps count] [--bloom-budget milliseconds]
+    if (!read_options(argc, argv, 1)) return 1;
+
     initialize();
 
     while (g_app_status == RUNNING)
     {
         process_input();
         update();
-        render();
+        if (render()) g_frame_pacer.wait();
+        else wait_for_change();
     }
 
     shutdown();
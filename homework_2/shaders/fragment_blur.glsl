@@ -0,0 +1,20 @@
+
+// TAPS comes from whoever loads this, as "#define TAPS 3". A constant count lets the loop
+// unroll; software GL runs every iteration of a loop bounded by a uniform.
+
+uniform sampler2D diffuse;
+uniform vec2 direction;                 // one texel, along the blur
+uniform float weights[TAPS + 1];        // centre first, then each pair of taps either side
+uniform float offsets[TAPS + 1];        // in texels; between two, so one bilinear tap reads both
+varying vec2 texCoordVar;
+
+void main() {
+    vec3 colour = texture2D(diffuse, texCoordVar).rgb * weights[0];
+
+    for (int i = 1; i <= TAPS; i++) {
+        vec2 offset = direction * offsets[i];
+        colour += (texture2D(diffuse, texCoordVar + offset).rgb + texture2D(diffuse, texCoordVar - offset).rgb) * weights[i];
+    }
+
+    gl_FragColor = vec4(colour, 1.0);
+}
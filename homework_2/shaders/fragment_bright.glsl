@@ -0,0 +1,16 @@
+
+uniform sampler2D diffuse;
+uniform float threshold;
+varying vec2 texCoordVar;
+
+void main() {
+    // at half size this lands where four of the frame's pixels meet, so the one bilinear tap
+    // averages them all; at a quarter it gets the middle four of sixteen, which the blur hides
+    vec3 colour = texture2D(diffuse, texCoordVar).rgb;
+
+    // by the brightest channel, not luminance, or the saturated blues and purples would never glow
+    float brightness = max(colour.r, max(colour.g, colour.b));
+    colour *= max(brightness - threshold, 0.0) / max(brightness, 0.0001);
+
+    gl_FragColor = vec4(colour, 1.0);
+}
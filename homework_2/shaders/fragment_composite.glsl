@@ -0,0 +1,9 @@
+
+uniform sampler2D scene;
+uniform sampler2D bloom;
+uniform float intensity;
+varying vec2 texCoordVar;
+
+void main() {
+    gl_FragColor = vec4(texture2D(scene, texCoordVar).rgb + texture2D(bloom, texCoordVar).rgb * intensity, 1.0);
+}
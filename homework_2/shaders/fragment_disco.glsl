@@ -0,0 +1,51 @@
+
+uniform float time;
+varying vec2 texCoordVar;
+
+const float TILES = 21.0;       // across the whole scene quad
+const float GROUT = 0.045;      // half the black line between tiles, in tiles
+const float BEAT  = 0.75;       // seconds each tile holds a colour
+const float FADE  = 0.3;        // how much of the beat goes on blending into the next one
+
+// Arithmetic only, no sin(), which is both slow and different on every GPU
+float hash(vec2 p)
+{
+    vec3 q = fract(vec3(p.xyx) * 0.1031);
+    q += dot(q, q.yzx + 33.33);
+    return fract((q.x + q.y) * q.z);
+}
+
+// Cyan comes up twice as often, like on the old floor textures
+vec3 palette(float index)
+{
+    if (index < 1.0) return vec3(0.71, 0.18, 0.88);     // purple
+    if (index < 2.0) return vec3(0.91, 0.08, 0.17);     // red
+    if (index < 4.0) return vec3(0.03, 0.91, 0.96);     // cyan
+    if (index < 5.0) return vec3(0.02, 0.18, 0.95);     // blue
+    if (index < 6.0) return vec3(0.99, 0.85, 0.17);     // yellow
+    return vec3(0.35, 0.98, 0.30);                      // green
+}
+
+vec3 tile_colour(vec2 tile, float beat)
+{
+    // the pattern repeats every 64 beats, which keeps the hash's input small enough to be exact
+    return palette(floor(hash(tile + mod(beat, 64.0) * vec2(0.37, 0.91)) * 7.0));
+}
+
+void main() {
+    vec2 position = texCoordVar * TILES;
+    vec2 tile = floor(position);
+
+    // every tile changes on its own part of the beat, so the floor shimmers rather than flashes
+    float phase = time / BEAT + hash(tile);
+    float beat = floor(phase);
+    vec3 colour = mix(tile_colour(tile, beat), tile_colour(tile, beat + 1.0),
+                      smoothstep(1.0 - FADE, 1.0, fract(phase)));
+
+    vec2 inside = fract(position);
+    vec2 edge = min(inside, 1.0 - inside);
+    float blur = length(fwidth(position)) * 0.5;
+    colour *= smoothstep(GROUT - blur, GROUT + blur, min(edge.x, edge.y));
+
+    gl_FragColor = vec4(colour, 1.0);
+}
@@ -0,0 +1,8 @@
+
+varying vec2 offsetVar;
+varying vec4 colourVar;
+
+void main() {
+    float glow = max(1.0 - dot(offsetVar, offsetVar), 0.0);     // brightest in the middle, gone at the edge
+    gl_FragColor = vec4(colourVar.rgb, colourVar.a * glow * glow);
+}
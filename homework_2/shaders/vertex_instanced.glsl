@@ -0,0 +1,23 @@
+attribute vec4 position;
+
+attribute vec2 instancePosition;
+attribute vec2 instanceScale;
+attribute float instanceRotation;
+attribute vec4 instanceFrame;       // u, v, width, height in the texture
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+
+varying vec2 texCoordVar;
+
+void main()
+{
+    float c = cos(instanceRotation);
+    float s = sin(instanceRotation);
+    vec2 scaled = position.xy * instanceScale;
+    vec2 world = vec2(c * scaled.x - s * scaled.y, s * scaled.x + c * scaled.y) + instancePosition;
+
+    // the unit quad's corners run from -0.5 to 0.5; the top of the frame is its lowest v
+    texCoordVar = instanceFrame.xy + vec2(position.x + 0.5, 0.5 - position.y) * instanceFrame.zw;
+    gl_Position = projectionMatrix * viewMatrix * vec4(world, 0.0, 1.0);
+}
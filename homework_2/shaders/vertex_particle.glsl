@@ -0,0 +1,17 @@
+attribute vec4 position;
+
+attribute vec3 particle;            // x, y, size
+attribute vec4 particleColour;
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+
+varying vec2 offsetVar;
+varying vec4 colourVar;
+
+void main()
+{
+    offsetVar = position.xy * 2.0;  // -1 to 1 across the quad
+    colourVar = particleColour;
+    gl_Position = projectionMatrix * viewMatrix * vec4(particle.xy + position.xy * particle.z, 0.0, 1.0);
+}
@@ -0,0 +1,10 @@
+attribute vec4 position;
+
+varying vec2 texCoordVar;
+
+// A triangle big enough to cover the whole screen, in clip space already
+void main()
+{
+    texCoordVar = position.xy * 0.5 + 0.5;
+    gl_Position = vec4(position.xy, 0.0, 1.0);
+}